@@ -0,0 +1,46 @@
+#include <SimpleBase64.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+
+// 比较各指令集实现编码/解码 8 MiB 随机数据的吞吐（MiB/s）
+int main() {
+    using SimpleBase64::detail::isa;
+    constexpr std::size_t size = 8 << 20;
+    constexpr double mib = static_cast<double>(size) / (1 << 20);
+
+    std::vector<std::uint8_t> data(size);
+    std::mt19937 rng(1);
+    for (auto& b : data) b = static_cast<std::uint8_t>(rng());
+
+    std::string encoded(SimpleBase64::encoded_size(size), '\0');
+    SimpleBase64::detail::encode(data.data(), size, encoded.data(), isa::scalar);
+    std::vector<std::uint8_t> decoded(SimpleBase64::decoded_size(encoded.size()));
+
+    std::printf("%-8s %14s %14s\n", "isa", "encode MiB/s", "decode MiB/s");
+    for (const auto& [which, name] : {std::pair{isa::scalar, "scalar"}, std::pair{isa::ssse3, "ssse3"}, std::pair{isa::avx2, "avx2"}}) {
+        if (!SimpleBase64::detail::isa_supported(which)) {
+            std::printf("%-8s unsupported\n", name);
+            continue;
+        }
+        const double encode = l2q_bench::best_of(10, [&] {
+            l2q_bench::do_not_optimize(SimpleBase64::detail::encode(data.data(), size, encoded.data(), which));
+        });
+        const double strict = l2q_bench::best_of(10, [&] {
+            l2q_bench::do_not_optimize(SimpleBase64::detail::decode(encoded, decoded.data(), SimpleBase64::decode_mode::strict, which));
+        });
+        std::printf("%-8s %14.0f %14.0f\n", name, mib / encode, mib / strict);
+    }
+
+    // 参考：旧的逐字符解码，宽松模式遇到非法输入时退回到它
+    const double lenient = l2q_bench::best_of(10, [&] {
+        l2q_bench::do_not_optimize(SimpleBase64::detail::decode_lenient(encoded, decoded.data()));
+    });
+    std::printf("%-8s %14s %14.0f\n", "per-char", "-", mib / lenient);
+    return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+
+namespace l2q_bench {
+    // 防止编译器把结果未被使用的计算优化掉
+    template <typename T>
+    inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    // 运行 fn rounds 次，返回单次最短耗时（秒），排除预热与调度抖动
+    template <typename Fn>
+    double best_of(int rounds, Fn&& fn) {
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < rounds; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+} // namespace l2q_bench
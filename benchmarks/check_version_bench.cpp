@@ -0,0 +1,71 @@
+#include "src/release_catalog.hpp"
+#include "src/update_service.hpp"
+
+#include <cstdio>
+#include <string>
+
+#include "bench.hpp"
+
+namespace {
+    l2q_http::request_args make_args(std::string version) {
+        l2q_http::request_args args{.method = l2q_http::http_method::get};
+        args.params.insert_or_assign(std::string{"os-arch"}, std::string{"linux-x64"});
+        args.params.insert_or_assign(std::string{"channel"}, std::string{"stable"});
+        args.params.insert_or_assign(std::string{"version"}, std::move(version));
+        return args;
+    }
+
+    // 计算路径之后会话还要序列化 JSON 与响应头，这里按 http_server_wrapper 的方式补上这部分
+    std::size_t serialize(const l2q_http::request_result& result) {
+        if (result.raw) {
+            return result.raw->size();
+        }
+        const auto headers = fmt::format("ETag: {}\r\nCache-Control: {}\r\nVary: {}\r\n", result.etag, result.cache_control, l2q_http::negotiated_vary);
+        return l2q_http::serialize_response(result.code, result.content_type, headers, result.data.dump()).size();
+    }
+} // namespace
+
+// GET /update/check/{os-arch}/{channel}/{version} 的单次请求 CPU 时间：
+// 已知版本命中预先生成的响应字节，未知版本走计算路径（查询 + JSON + 序列化）
+int main() {
+    nlohmann::json releases = nlohmann::json::array();
+    for (const auto* arch : {"windows-x64", "linux-x64", "linux-arm64"}) {
+        for (const auto* channel : {"stable", "beta", "nightly"}) {
+            for (int minor = 0; minor < 100; ++minor) {
+                releases.push_back({
+                    {"version", fmt::format("1.{}", minor)},
+                    {"os-arch", arch},
+                    {"channel", channel},
+                    {"critical", minor % 10 == 0},
+                    {"package", fmt::format("{}/{}/1.{}.bin", arch, channel, minor)},
+                });
+            }
+        }
+    }
+
+    l2q_http::release_catalog catalog;
+    catalog.publish(catalog.build({{"releases", releases}}, "."));
+    const l2q_http::update_service service(catalog);
+
+    constexpr int iterations = 200000;
+    // check_version_get 只读取参数，同一个 args 可以反复传入
+    auto known = make_args("1.42");
+    auto unknown = make_args("1.42.7");
+    if (!service.check_version_get(std::move(known)).raw || service.check_version_get(std::move(unknown)).raw) {
+        std::fprintf(stderr, "unexpected response path\n");
+        return 1;
+    }
+
+    const auto run = [&](l2q_http::request_args& args) {
+        return l2q_bench::best_of(5, [&] {
+            for (int i = 0; i < iterations; ++i) {
+                l2q_bench::do_not_optimize(serialize(service.check_version_get(std::move(args))));
+            }
+        }) / iterations;
+    };
+    const double precomputed = run(known);
+    const double computed = run(unknown);
+    std::printf("precomputed %8.0f ns/request\n", precomputed * 1e9);
+    std::printf("computed    %8.0f ns/request\n", computed * 1e9);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "src/compress.h"
+#include "src/response_dictionary.hpp"
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "bench.hpp"
+
+// 典型 JSON 响应在 gzip、普通 deflate 与预置字典 deflate 下的大小，以及单次压缩耗时
+int main() {
+    const auto& dictionary = l2q_http::response_dictionaries.back();
+    constexpr std::string_view bodies[] = {
+        R"({"flags":1,"version":"1.4.2"})",
+        R"({"flags":0,"version":"2.0.17"})",
+        R"({"reason":"unknown arch"})",
+        R"({"reason":"invalid version"})",
+        R"([{"component":"app","flags":1,"version":"1.4.2"},{"component":"plugin","flags":0,"version":"0.9"}])",
+    };
+    constexpr int iterations = 20000;
+
+    std::printf("dictionary %.*s (%zu bytes)\n\n", static_cast<int>(dictionary.id.size()), dictionary.id.data(), dictionary.data.size());
+    std::printf("%-6s %6s %8s %8s %8s %10s %10s\n", "body", "raw", "gzip", "deflate", "dict", "plain us", "dict us");
+    std::size_t total_raw = 0, total_gzip = 0, total_plain = 0, total_dict = 0;
+    for (std::size_t i = 0; i < std::size(bodies); ++i) {
+        const auto body = bodies[i];
+        const auto gzip = gzip_compress(body);
+        const auto plain = deflate_compress(body, {});
+        const auto dict = deflate_compress(body, dictionary.data);
+        if (!gzip || !plain || !dict) {
+            std::fprintf(stderr, "compression failed\n");
+            return 1;
+        }
+
+        std::string decoded;
+        if (l2q_http::decode_dictionary_response(*dict, dictionary.id, decoded) != inflate_status::ok || decoded != body) {
+            std::fprintf(stderr, "dictionary round trip failed\n");
+            return 1;
+        }
+
+        const double plain_time = l2q_bench::best_of(5, [&] {
+            for (int n = 0; n < iterations; ++n) l2q_bench::do_not_optimize(deflate_compress(body, {}));
+        }) / iterations;
+        const double dict_time = l2q_bench::best_of(5, [&] {
+            for (int n = 0; n < iterations; ++n) l2q_bench::do_not_optimize(deflate_compress(body, dictionary.data));
+        }) / iterations;
+
+        std::printf("%-6zu %6zu %8zu %8zu %8zu %10.2f %10.2f\n", i, body.size(), gzip->size(), plain->size(), dict->size(),
+                    plain_time * 1e6, dict_time * 1e6);
+        total_raw += body.size();
+        total_gzip += gzip->size();
+        total_plain += plain->size();
+        total_dict += dict->size();
+    }
+    std::printf("%-6s %6zu %8zu %8zu %8zu\n", "total", total_raw, total_gzip, total_plain, total_dict);
+    return 0;
+}
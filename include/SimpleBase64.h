@@ -1,59 +1,396 @@
 #pragma once
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define SIMPLE_BASE64_X86 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#    define SIMPLE_BASE64_TARGET(isa)
+#  else
+#    define SIMPLE_BASE64_TARGET(isa) __attribute__((target(isa)))
+#  endif
+#else
+#  define SIMPLE_BASE64_X86 0
+#endif
+
 namespace SimpleBase64 {
 
-    static const char* base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-                                      "abcdefghijklmnopqrstuvwxyz"
-                                      "0123456789+/";
+    enum class decode_mode {
+        lenient, // 跳过非法字符，遇到 '=' 停止（旧行为）
+        strict,  // 长度必须为 4 的倍数，只允许末尾最多两个 '='，填充前的多余比特必须为 0
+    };
+
+    namespace detail {
+        inline constexpr std::array<char, 64> encode_table = [] {
+            std::array<char, 64> table{};
+            constexpr std::string_view chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for (std::size_t i = 0; i < 64; ++i) table[i] = chars[i];
+            return table;
+        }();
+
+        // 非法字符为 -1
+        inline constexpr std::array<std::int8_t, 256> decode_table = [] {
+            std::array<std::int8_t, 256> table{};
+            for (auto& v : table) v = -1;
+            for (std::size_t i = 0; i < 64; ++i) table[static_cast<unsigned char>(encode_table[i])] = static_cast<std::int8_t>(i);
+            return table;
+        }();
+
+        // 以 3 字节为一组编码，返回写入的字符数
+        inline std::size_t encode_scalar(const std::uint8_t* data, std::size_t len, char* out) noexcept {
+            char* const begin = out;
+            std::size_t i = 0;
+            for (; i + 3 <= len; i += 3) {
+                const std::uint32_t v = std::uint32_t{data[i]} << 16 | std::uint32_t{data[i + 1]} << 8 | data[i + 2];
+                *out++ = encode_table[v >> 18 & 0x3F];
+                *out++ = encode_table[v >> 12 & 0x3F];
+                *out++ = encode_table[v >> 6 & 0x3F];
+                *out++ = encode_table[v & 0x3F];
+            }
+
+            if (const auto rest = len - i; rest != 0) {
+                const std::uint32_t v = std::uint32_t{data[i]} << 16 | (rest == 2 ? std::uint32_t{data[i + 1]} << 8 : 0);
+                *out++ = encode_table[v >> 18 & 0x3F];
+                *out++ = encode_table[v >> 12 & 0x3F];
+                *out++ = rest == 2 ? encode_table[v >> 6 & 0x3F] : '=';
+                *out++ = '=';
+            }
+            return static_cast<std::size_t>(out - begin);
+        }
+
+        // 严格解码不含填充的完整 4 字符组，返回成功解码的组数（遇到非法字符提前停止）
+        inline std::size_t decode_quads_scalar(const char* str, std::size_t quads, std::uint8_t* out) noexcept {
+            for (std::size_t q = 0; q < quads; ++q, str += 4, out += 3) {
+                const auto a = decode_table[static_cast<unsigned char>(str[0])];
+                const auto b = decode_table[static_cast<unsigned char>(str[1])];
+                const auto c = decode_table[static_cast<unsigned char>(str[2])];
+                const auto d = decode_table[static_cast<unsigned char>(str[3])];
+                if ((a | b | c | d) < 0) return q;
+
+                const std::uint32_t v = std::uint32_t(a) << 18 | std::uint32_t(b) << 12 | std::uint32_t(c) << 6 | std::uint32_t(d);
+                out[0] = static_cast<std::uint8_t>(v >> 16);
+                out[1] = static_cast<std::uint8_t>(v >> 8);
+                out[2] = static_cast<std::uint8_t>(v);
+            }
+            return quads;
+        }
+
+        // 可用的指令集实现，非 x86 平台只有 scalar
+        enum class isa { scalar, ssse3, avx2 };
+
+#if SIMPLE_BASE64_X86
+        inline isa detect_isa() noexcept {
+#  if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            const int max_leaf = info[0];
+            __cpuid(info, 1);
+            const bool ssse3 = info[2] & (1 << 9);
+            const bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+            bool avx2 = false;
+            if (max_leaf >= 7 && os_avx) {
+                __cpuidex(info, 7, 0);
+                avx2 = info[1] & (1 << 5);
+            }
+#  else
+            __builtin_cpu_init();
+            const bool ssse3 = __builtin_cpu_supports("ssse3");
+            const bool avx2 = __builtin_cpu_supports("avx2");
+#  endif
+            return avx2 ? isa::avx2 : ssse3 ? isa::ssse3 : isa::scalar;
+        }
+
+        // 进程启动时通过 cpuid 检测一次
+        inline const isa active_isa = detect_isa();
+
+        inline bool isa_supported(isa which) noexcept {
+            return which <= active_isa;
+        }
+
+        // 见 Wojciech Muła, "Faster Base64 Encoding and Decoding using AVX2 Instructions"
+        SIMPLE_BASE64_TARGET("ssse3")
+        inline __m128i enc_reshuffle(const __m128i in) noexcept {
+            const __m128i t = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+            const __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(t, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+            const __m128i t1 = _mm_mullo_epi16(_mm_and_si128(t, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+            return _mm_or_si128(t0, t1);
+        }
+
+        SIMPLE_BASE64_TARGET("ssse3")
+        inline __m128i enc_translate(const __m128i indices) noexcept {
+            // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12，再查表得到与 ASCII 的偏移
+            __m128i offset = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+            offset = _mm_or_si128(offset, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+            const __m128i lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+            return _mm_add_epi8(indices, _mm_shuffle_epi8(lut, offset));
+        }
+
+        SIMPLE_BASE64_TARGET("ssse3")
+        inline std::size_t encode_ssse3(const std::uint8_t*& data, std::size_t len, char*& out) noexcept {
+            // 每次读取 16 字节、消耗 12 字节
+            std::size_t done = 0;
+            for (; done + 16 <= len; done += 12, data += 12, out += 16) {
+                const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), enc_translate(enc_reshuffle(in)));
+            }
+            return done;
+        }
+
+        SIMPLE_BASE64_TARGET("avx2")
+        inline std::size_t encode_avx2(const std::uint8_t*& data, std::size_t len, char*& out) noexcept {
+            // 两个 128 位通道各处理 12 字节，每次读取 28 字节、消耗 24 字节
+            std::size_t done = 0;
+            for (; done + 28 <= len; done += 24, data += 24, out += 32) {
+                __m256i in = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data))),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 12)), 1);
+
+                in = _mm256_shuffle_epi8(in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                                             10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+                const __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+                const __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+                const __m256i indices = _mm256_or_si256(t0, t1);
+
+                __m256i offset = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+                offset = _mm256_or_si256(offset, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+                const __m256i lut = _mm256_setr_epi8(
+                    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_add_epi8(indices, _mm256_shuffle_epi8(lut, offset)));
+            }
+            return done;
+        }
+
+        // 校验并把 16 个字符转换为 6 比特值，存在非法字符时返回 false
+        SIMPLE_BASE64_TARGET("ssse3")
+        inline bool dec_translate(__m128i& str) noexcept {
+            const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+            const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+            const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i mask_2f = _mm_set1_epi8(0x2f);
+
+            const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+            const __m128i lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(str, mask_2f));
+            const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF) {
+                return false;
+            }
+
+            const __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f);
+            str = _mm_add_epi8(str, _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles)));
+            return true;
+        }
+
+        SIMPLE_BASE64_TARGET("ssse3")
+        inline std::size_t decode_ssse3(const char*& str, std::size_t len, std::uint8_t*& out) noexcept {
+            // 每次读取 16 个字符、写入 16 字节（其中 12 字节有效），末尾至少保留 4 个字符保证写入不越界
+            std::size_t done = 0;
+            for (; done + 20 <= len; done += 16, str += 16, out += 12) {
+                __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+                if (!dec_translate(in)) break;
+
+                const __m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+                const __m128i packed = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+            }
+            return done;
+        }
+
+        SIMPLE_BASE64_TARGET("avx2")
+        inline std::size_t decode_avx2(const char*& str, std::size_t len, std::uint8_t*& out) noexcept {
+            const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                                    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+            const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                                    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+            const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+
+            // 每次读取 32 个字符、写入 32 字节（其中 24 字节有效），末尾至少保留 12 个字符保证写入不越界
+            std::size_t done = 0;
+            for (; done + 44 <= len; done += 32, str += 32, out += 24) {
+                __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str));
+
+                const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_2f);
+                const __m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(in, mask_2f));
+                const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+                if (!_mm256_testz_si256(lo, hi)) break;
+
+                const __m256i eq_2f = _mm256_cmpeq_epi8(in, mask_2f);
+                in = _mm256_add_epi8(in, _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles)));
+
+                __m256i packed = _mm256_madd_epi16(_mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+                packed = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                                      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+                packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), packed);
+            }
+            return done;
+        }
+#else
+        inline constexpr isa active_isa = isa::scalar;
+
+        inline bool isa_supported(isa which) noexcept {
+            return which == isa::scalar;
+        }
+#endif
+
+        /**
+         * @brief 用指定的指令集编码，which 必须满足 isa_supported（测试与基准用它比较各实现）
+         */
+        inline std::size_t encode(const std::uint8_t* data, std::size_t len, char* out, isa which) noexcept {
+            char* const begin = out;
+#if SIMPLE_BASE64_X86
+            if (which == isa::avx2) {
+                len -= encode_avx2(data, len, out);
+            }
+            if (which != isa::scalar) {
+                len -= encode_ssse3(data, len, out);
+            }
+#endif
+            return static_cast<std::size_t>(out - begin) + encode_scalar(data, len, out);
+        }
+
+        /**
+         * @brief 严格解码，out 需至少有 decoded_size 字节，失败返回 std::nullopt
+         */
+        inline std::optional<std::size_t> decode_strict(std::string_view str, std::uint8_t* out, isa which = active_isa) noexcept {
+            if (str.size() % 4 != 0) return std::nullopt;
+            if (str.empty()) return 0;
+
+            const std::size_t padding = str.back() != '=' ? 0 : str[str.size() - 2] != '=' ? 1 : 2;
+            std::uint8_t* const begin = out;
+            const char* p = str.data();
+
+            // 最后一组可能含填充，单独处理
+            std::size_t body = str.size() - 4;
+#if SIMPLE_BASE64_X86
+            if (which == isa::avx2) {
+                body -= decode_avx2(p, body, out);
+            }
+            if (which != isa::scalar) {
+                body -= decode_ssse3(p, body, out);
+            }
+#endif
+            const std::size_t quads = body / 4;
+            if (decode_quads_scalar(p, quads, out) != quads) return std::nullopt;
+            p += body;
+            out += quads * 3;
+
+            const auto a = decode_table[static_cast<unsigned char>(p[0])];
+            const auto b = decode_table[static_cast<unsigned char>(p[1])];
+            const auto c = padding >= 2 ? std::int8_t{0} : decode_table[static_cast<unsigned char>(p[2])];
+            const auto d = padding >= 1 ? std::int8_t{0} : decode_table[static_cast<unsigned char>(p[3])];
+            if ((a | b | c | d) < 0) return std::nullopt;
+
+            const std::uint32_t v = std::uint32_t(a) << 18 | std::uint32_t(b) << 12 | std::uint32_t(c) << 6 | std::uint32_t(d);
+            // 填充前未使用的比特必须为 0，保证编码唯一
+            if ((padding == 1 && (v & 0xFF)) || (padding == 2 && (v & 0xFFFF))) return std::nullopt;
+
+            *out++ = static_cast<std::uint8_t>(v >> 16);
+            if (padding < 2) *out++ = static_cast<std::uint8_t>(v >> 8);
+            if (padding < 1) *out++ = static_cast<std::uint8_t>(v);
+            return static_cast<std::size_t>(out - begin);
+        }
+
+        // 旧行为：跳过非法字符，遇到 '=' 停止
+        inline std::size_t decode_lenient(std::string_view str, std::uint8_t* out) noexcept {
+            std::uint8_t* const begin = out;
+            int val = 0, valb = -8;
+            for (unsigned char c : str) {
+                const int v = decode_table[c];
+                if (v == -1) {
+                    if (c == '=')
+                        break; // padding
+                    else
+                        continue; // skip invalid chars
+                }
+                val = (val << 6) + v;
+                valb += 6;
+                if (valb >= 0) {
+                    *out++ = std::uint8_t((val >> valb) & 0xFF);
+                    valb -= 8;
+                }
+            }
+            return static_cast<std::size_t>(out - begin);
+        }
+
+        inline std::optional<std::size_t> decode(std::string_view str, std::uint8_t* out, decode_mode mode, isa which) noexcept {
+            if (mode == decode_mode::strict) {
+                return decode_strict(str, out, which);
+            }
+            // 合法输入走快速路径，否则退回逐字符处理
+            if (auto size = decode_strict(str, out, which)) {
+                return size;
+            }
+            return decode_lenient(str, out);
+        }
+    } // namespace detail
+
+    // 编码 len 字节所需的字符数
+    constexpr std::size_t encoded_size(std::size_t len) noexcept { return (len + 2) / 3 * 4; }
+
+    // 解码 len 个字符最多产生的字节数
+    constexpr std::size_t decoded_size(std::size_t len) noexcept { return (len + 3) / 4 * 3; }
+
+    /**
+     * @brief 编码到预先分配好的内存，out 至少需要 encoded_size(len) 字节
+     * @return 写入的字符数
+     */
+    inline std::size_t encode_into(const std::uint8_t* data, std::size_t len, char* out) noexcept {
+        return detail::encode(data, len, out, detail::active_isa);
+    }
+
+    /**
+     * @brief 解码到预先分配好的内存，out 至少需要 decoded_size(str.size()) 字节
+     * @return 写入的字节数，strict 模式下输入非法时返回 std::nullopt
+     */
+    inline std::optional<std::size_t> decode_into(std::string_view str, std::uint8_t* out, decode_mode mode = decode_mode::strict) noexcept {
+        return detail::decode(str, out, mode, detail::active_isa);
+    }
 
     // 编码
     inline std::string encode(const std::uint8_t* data, std::size_t len) {
-        std::string ret;
-        ret.reserve((len + 2) / 3 * 4);
-        int val = 0, valb = -6;
-        for (std::size_t i = 0; i < len; ++i) {
-            val = (val << 8) + data[i];
-            valb += 8;
-            while (valb >= 0) {
-                ret.push_back(base64_chars[(val >> valb) & 0x3F]);
-                valb -= 6;
-            }
-        }
-        if (valb > -6)
-            ret.push_back(base64_chars[((val << 8) >> (valb + 8)) & 0x3F]);
-        while (ret.size() % 4)
-            ret.push_back('=');
+        std::string ret(encoded_size(len), '\0');
+        encode_into(data, len, ret.data());
         return ret;
     }
 
     inline std::string encode(const std::vector<std::uint8_t>& data) { return encode(data.data(), data.size()); }
 
-    // 解码
+    inline std::string encode(std::string_view data) {
+        return encode(reinterpret_cast<const std::uint8_t*>(data.data()), data.size());
+    }
+
+    // 解码（宽松模式：跳过非法字符，遇到 '=' 停止）
     inline std::vector<std::uint8_t> decode(const std::string& str) {
-        std::vector<std::uint8_t> ret;
-        std::vector<int> T(256, -1);
-        for (int i = 0; i < 64; i++)
-            T[static_cast<unsigned char>(base64_chars[i])] = i;
-
-        int val = 0, valb = -8;
-        for (unsigned char c : str) {
-            if (T[c] == -1) {
-                if (c == '=')
-                    break; // padding
-                else
-                    continue; // skip invalid chars
-            }
-            val = (val << 6) + T[c];
-            valb += 6;
-            if (valb >= 0) {
-                ret.push_back(std::uint8_t((val >> valb) & 0xFF));
-                valb -= 8;
-            }
+        std::vector<std::uint8_t> ret(decoded_size(str.size()));
+        ret.resize(*decode_into(str, ret.data(), decode_mode::lenient));
+        return ret;
+    }
+
+    /**
+     * @brief 严格解码
+     * @throw std::invalid_argument 输入不是规范的 Base64
+     */
+    inline std::vector<std::uint8_t> decode_strict(std::string_view str) {
+        std::vector<std::uint8_t> ret(decoded_size(str.size()));
+        const auto size = decode_into(str, ret.data(), decode_mode::strict);
+        if (!size) {
+            throw std::invalid_argument("invalid base64 input");
         }
+        ret.resize(*size);
         return ret;
     }
 
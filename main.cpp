@@ -6,7 +6,18 @@
 #include <spdlog/spdlog.h>
 
 #include <memory>
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
 #include "src/http_server_wrapper.hpp"
+#include "src/delta_updates.hpp"
+#include "src/manifest_watcher.hpp"
+#include "src/release_notifier.hpp"
+#include "src/release_publisher.hpp"
+#include "src/update_service.hpp"
 
 
 void setup_logging() {
@@ -27,12 +38,47 @@ void setup_logging() {
     spdlog::set_default_logger(logger);
     spdlog::flush_on(spdlog::level::debug);
 }
+
+/**
+ * @brief 把打开文件数的软限制提高到硬限制，推送通道的每个订阅者占用一个描述符
+ */
+void raise_file_limit() {
+#if defined(__unix__) || defined(__APPLE__)
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+            spdlog::warn("cannot raise the open file limit");
+        }
+    }
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        spdlog::info("open file limit: {}", static_cast<std::uint64_t>(limit.rlim_cur));
+    }
+#endif
+}
 // --- 用户业务代码示例 ---
 
 int main(int argc, char* argv[]) {
     setup_logging();
     try {
         std::uint16_t port = 10000;
+        std::filesystem::path manifest = "releases/manifest.json";
+        // fetch_latest 等待合并构建结果的最长时间，超时返回 503
+        std::chrono::seconds build_timeout{30};
+
+        // Lab2QRCode-HttpService --compile-catalog [manifest]：把清单编译为二进制镜像后退出
+        if (argc >= 2 && std::string_view{argv[1]} == "--compile-catalog") {
+            if (argc >= 3) {
+                manifest = argv[2];
+            }
+            l2q_http::package_store packages(manifest.parent_path() / "store");
+            l2q_http::release_catalog catalog(&packages, packages.root() / "catalog.bin");
+            const auto start = std::chrono::steady_clock::now();
+            const auto snapshot = catalog.compile_image(manifest);
+            spdlog::info("compiled {} releases into {} in {}ms", snapshot->release_count(), (packages.root() / "catalog.bin").string(),
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+            return 0;
+        }
 
         if (argc >= 2) {
             std::string_view port_arg = argv[1];
@@ -51,7 +97,34 @@ int main(int argc, char* argv[]) {
             }
         }
 
+        if (argc >= 3) {
+            manifest = argv[2];
+        }
+
+        if (argc >= 4) {
+            std::string_view timeout_arg = argv[3];
+            std::uint32_t parsed_timeout = 0;
+
+            auto [ptr, ec] = std::from_chars(
+                timeout_arg.data(),
+                timeout_arg.data() + timeout_arg.size(),
+                parsed_timeout
+            );
+
+            if (ec == std::errc() && ptr == timeout_arg.data() + timeout_arg.size() && parsed_timeout != 0) {
+                build_timeout = std::chrono::seconds{parsed_timeout};
+            } else {
+                spdlog::warn("invalid build timeout argument '{}', using default {}s", timeout_arg, build_timeout.count());
+            }
+        }
+
+        raise_file_limit();
         asio::io_context io_context(1); // 单线程模型
+        // 耗时的响应构建放到独立的线程池，不阻塞事件循环；只用于请求触发的 fetch_latest 构建，
+        // 不会排在秒级的差分与分块之后而超时
+        asio::thread_pool build_pool(2);
+        // 发布流水线与启动时的准备（入库、差分、分块）在这里串行执行
+        asio::thread_pool prepare_pool(1);
 
         asio::signal_set signals(io_context, SIGINT, SIGTERM);
         signals.async_wait([&](auto, auto){
@@ -59,15 +132,135 @@ int main(int argc, char* argv[]) {
             io_context.stop();
         });
 
+        l2q_http::adaptive_compression_level compression_level;
+        l2q_http::response_cache response_cache;
+        l2q_http::package_store packages(manifest.parent_path() / "store");
+        // 预先生成的响应在发布时与关闭时写入磁盘，重启后直接映射
+        l2q_http::response_spill spill(packages.root() / "responses");
+        // 清单未变化时从镜像启动，不解析 JSON
+        l2q_http::release_catalog catalog(&packages, packages.root() / "catalog.bin", &spill);
+        l2q_http::update_service::payload_builds payload_builds(build_pool.get_executor(), build_timeout);
+        l2q_http::delta_updates deltas(packages);
+        l2q_http::chunk_store chunks(packages.root());
+        l2q_http::update_service update_service(catalog, &response_cache, &payload_builds, &deltas, &chunks, &spill);
+        const auto prepare_chunks = [&](const l2q_http::catalog_snapshot& snapshot){
+            // 块列表是可选的下载格式：某个更新包分块失败（例如磁盘已满）只记录日志，不影响启动与发布
+            snapshot.for_each_latest([&](const l2q_http::package_info& package){
+                try {
+                    chunks.add(package, packages);
+                } catch (const std::exception& e) {
+                    spdlog::error("chunking sha256:{} failed: {}", package.sha256, e.what());
+                }
+            });
+        };
+        catalog.on_publish([&](const l2q_http::catalog_snapshot& snapshot){
+            update_service.evict_stale(snapshot);
+        });
+        // 客户端订阅推送代替定时轮询，发布改变了最新版本时通知
+        l2q_http::release_notifier notifier(io_context.get_executor(), catalog);
+        catalog.on_publish([&](const l2q_http::catalog_snapshot&){
+            notifier.refresh();
+        });
+        catalog.load_manifest(manifest);
+        asio::post(prepare_pool, [&]{
+            // 线程池上逃逸的异常会终止进程：每一步单独捕获，失败的步骤只记录日志，对应的响应在请求时按需构建
+            const auto snapshot = catalog.snapshot();
+            const auto guarded = [](const char* step, auto&& fn) {
+                try {
+                    fn();
+                } catch (const std::exception& e) {
+                    spdlog::error("startup {} preparation failed: {}", step, e.what());
+                }
+            };
+            guarded("fetch_latest", [&]{ update_service.prepare(*snapshot); });
+            guarded("delta", [&]{ deltas.prepare(*snapshot); });
+            guarded("chunk", [&]{ prepare_chunks(*snapshot); });
+        });
+
+        // 新版本在后台准备好所有响应后才对外可见
+        // 管理接口的令牌只从环境变量读取，不出现在命令行（进程列表）中
+        const char* admin_token = std::getenv("L2Q_ADMIN_TOKEN");
+        if (!admin_token || !*admin_token) {
+            spdlog::warn("L2Q_ADMIN_TOKEN is not set, POST /admin/releases is disabled");
+        }
+        l2q_http::release_publisher publisher(catalog, prepare_pool.get_executor(), manifest, admin_token ? admin_token : "");
+        publisher.on_prepare([&](const l2q_http::catalog_snapshot& snapshot){
+            deltas.prepare(snapshot);
+        });
+        publisher.on_prepare([&](const l2q_http::catalog_snapshot& snapshot){
+            update_service.prepare(snapshot);
+        });
+        publisher.on_prepare(prepare_chunks);
+        publisher.watch(manifest.parent_path() / "incoming", std::chrono::seconds{2});
+
+        // 清单或更新包被直接修改时自动重新加载，不需要重启
+        notifier.start();
+
+        l2q_http::manifest_watcher watcher(io_context.get_executor(), publisher, catalog, manifest, std::chrono::milliseconds{500});
+        watcher.start();
+
         l2q_http::http_server server(io_context, port);
+        server.enable_compression(compression_level);
         server.route("/api/def", [](l2q_http::request_args&& args){
             auto v = args.body;
             return l2q_http::request_result{};
         });
+        server.route("/update/check_version", [&](l2q_http::request_args&& args){
+            return update_service.check_version(std::move(args));
+        });
+        server.route("/update/check_versions", [&](l2q_http::request_args&& args){
+            return update_service.check_versions(std::move(args));
+        });
+        server.route("/update/fetch_latest", [&](l2q_http::request_args&& args){
+            return update_service.fetch_latest(std::move(args));
+        });
+        server.route("/update/check/{os-arch}/{channel}/{version}", [&](l2q_http::request_args&& args){
+            return update_service.check_version_get(std::move(args));
+        });
+        server.route("/update/latest/{os-arch}/{channel}", [&](l2q_http::request_args&& args){
+            return update_service.fetch_latest_get(std::move(args));
+        });
+        server.route("/update/package/{os-arch}/{channel}", [&](l2q_http::request_args&& args){
+            return update_service.download_package(std::move(args));
+        });
+        server.route("/update/delta/{os-arch}/{channel}/{version}", [&](l2q_http::request_args&& args){
+            return update_service.download_delta(std::move(args));
+        });
+        server.route("/update/chunks/{os-arch}/{channel}", [&](l2q_http::request_args&& args){
+            return update_service.chunk_list(std::move(args));
+        });
+        server.route("/update/chunk/{sha256}", [&](l2q_http::request_args&& args){
+            return update_service.download_chunk(std::move(args));
+        });
+        server.route("/update/subscribe", [&](l2q_http::request_args&& args){
+            return notifier.subscribe(std::move(args));
+        });
+        server.route("/admin/releases", [&](l2q_http::request_args&& args){
+            return publisher.add_release(std::move(args));
+        });
+        server.route("/metrics", [&](l2q_http::request_args&&){
+            return l2q_http::request_result{nlohmann::json{
+                {"compression", compression_level.metrics()},
+                {"response_cache", response_cache.metrics()},
+                {"payload_builds", payload_builds.metrics()},
+                {"publisher", publisher.metrics()},
+                {"deltas", deltas.metrics()},
+                {"chunks", chunks.metrics()},
+                {"reload", watcher.metrics()},
+                {"spill", spill.metrics()},
+                {"subscribers", notifier.metrics()},
+            }};
+        });
         server.start();
 
         spdlog::info("running on: {} ...", port);
         io_context.run();
+        // 等待进行中的发布与构建结束，之后才能销毁它们引用的对象
+        prepare_pool.stop();
+        prepare_pool.join();
+        build_pool.stop();
+        build_pool.join();
+        spdlog::info("spilled {} cached responses", update_service.spill());
 
     } catch (const std::exception& e) {
         spdlog::critical("unhandled exception in main: {}", e.what());
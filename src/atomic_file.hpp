@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <spdlog/spdlog.h>
+
+namespace l2q_http{
+/**
+ * @brief 与 target 同目录的唯一临时文件名（<target>.<进程随机数>-<序号>.tmp）
+ * 同一进程内的多个线程、以及同时运行的多个进程写同一目标时各自使用不同的临时文件，互不覆盖；
+ * 以 .tmp 结尾，manifest_watcher 忽略这类文件
+ */
+inline std::filesystem::path unique_temp_path(const std::filesystem::path& target){
+	static const std::uint64_t salt = (std::uint64_t{std::random_device{}()} << 32) | std::random_device{}();
+	static std::atomic<std::uint64_t> sequence{0};
+	auto temp = target;
+	temp += fmt::format(".{:016x}-{}.tmp", salt, sequence.fetch_add(1, std::memory_order_relaxed));
+	return temp;
+}
+
+/**
+ * @brief 先写后重命名的临时文件：commit 之前析构（写入失败、抛出异常或内容已存在而放弃）时删除临时文件
+ * 重命名在同一文件系统内是原子的，读取方只会看到旧文件或完整的新文件
+ */
+class temp_file{
+public:
+	explicit temp_file(const std::filesystem::path& target)
+		: path_(unique_temp_path(target)){}
+
+	temp_file(const temp_file&) = delete;
+	temp_file& operator=(const temp_file&) = delete;
+
+	~temp_file(){
+		if(!path_.empty()){
+			std::error_code ec;
+			std::filesystem::remove(path_, ec);
+		}
+	}
+
+	[[nodiscard]] const std::filesystem::path& path() const noexcept{
+		return path_;
+	}
+
+	/**
+	 * @throw std::filesystem::filesystem_error 重命名失败（此时临时文件仍会在析构时删除）
+	 */
+	void commit(const std::filesystem::path& target){
+		std::filesystem::rename(path_, target);
+		path_.clear();
+	}
+
+private:
+	std::filesystem::path path_;
+};
+
+/**
+ * @brief 把 bytes 原子地写入 path（写入唯一的临时文件后重命名）
+ * @throw std::runtime_error 写入失败
+ * @throw std::filesystem::filesystem_error 重命名失败
+ */
+inline void write_file_atomic(const std::filesystem::path& path, const std::string_view bytes){
+	temp_file temp(path);
+	{
+		std::ofstream out(temp.path(), std::ios::binary | std::ios::trunc);
+		out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+		out.flush();
+		if(!out){
+			throw std::runtime_error("failed to write " + temp.path().string());
+		}
+	}
+	temp.commit(path);
+}
+} // namespace l2q_http
@@ -0,0 +1,411 @@
+#include "binary_delta.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace l2q_http {
+    namespace {
+        constexpr std::string_view delta_magic = "L2QDIFF1";
+
+        using index_type = std::int32_t;
+
+        void put_u64(std::string& out, std::uint64_t value) {
+            for (int i = 0; i < 8; ++i) {
+                out.push_back(static_cast<char>(value & 0xff));
+                value >>= 8;
+            }
+        }
+
+        std::optional<std::uint64_t> get_u64(std::string_view& in) noexcept {
+            if (in.size() < 8) {
+                return std::nullopt;
+            }
+            std::uint64_t value = 0;
+            for (int i = 7; i >= 0; --i) {
+                value = value << 8 | static_cast<unsigned char>(in[static_cast<std::size_t>(i)]);
+            }
+            in.remove_prefix(8);
+            return value;
+        }
+
+        /**
+         * @brief Larsson-Sadakane 后缀排序（与 bsdiff 相同），I 为后缀数组，V 为各后缀所在组的序号
+         */
+        class suffix_sorter {
+        public:
+            suffix_sorter(std::vector<index_type>& I, std::vector<index_type>& V) noexcept : I(I), V(V) {}
+
+            void sort(const unsigned char* data, const index_type size) {
+                std::array<index_type, 256> buckets{};
+                for (index_type i = 0; i < size; ++i) {
+                    ++buckets[data[i]];
+                }
+                for (std::size_t i = 1; i < buckets.size(); ++i) {
+                    buckets[i] += buckets[i - 1];
+                }
+                for (std::size_t i = buckets.size() - 1; i > 0; --i) {
+                    buckets[i] = buckets[i - 1];
+                }
+                buckets[0] = 0;
+
+                for (index_type i = 0; i < size; ++i) {
+                    I[++buckets[data[i]]] = i;
+                }
+                I[0] = size;
+                for (index_type i = 0; i < size; ++i) {
+                    V[i] = buckets[data[i]];
+                }
+                V[size] = 0;
+                for (std::size_t i = 1; i < buckets.size(); ++i) {
+                    if (buckets[i] == buckets[i - 1] + 1) {
+                        I[buckets[i]] = -1;
+                    }
+                }
+                I[0] = -1;
+
+                for (index_type h = 1; I[0] != -(size + 1); h += h) {
+                    index_type len = 0;
+                    index_type i = 0;
+                    while (i < size + 1) {
+                        if (I[i] < 0) {
+                            len -= I[i];
+                            i -= I[i];
+                        } else {
+                            if (len) {
+                                I[i - len] = -len;
+                            }
+                            len = V[I[i]] + 1 - i;
+                            split(i, len, h);
+                            i += len;
+                            len = 0;
+                        }
+                    }
+                    if (len) {
+                        I[i - len] = -len;
+                    }
+                }
+
+                for (index_type i = 0; i < size + 1; ++i) {
+                    I[V[i]] = i;
+                }
+            }
+
+        private:
+            void split(index_type start, index_type len, const index_type h) {
+                // 右侧分组改为循环处理，递归深度只来自左侧
+                while (len > 0) {
+                    if (len < 16) {
+                        split_small(start, len, h);
+                        return;
+                    }
+
+                    const index_type x = V[I[start + len / 2] + h];
+                    index_type jj = 0;
+                    index_type kk = 0;
+                    for (index_type i = start; i < start + len; ++i) {
+                        if (V[I[i] + h] < x) ++jj;
+                        if (V[I[i] + h] == x) ++kk;
+                    }
+                    jj += start;
+                    kk += jj;
+
+                    index_type i = start;
+                    index_type j = 0;
+                    index_type k = 0;
+                    while (i < jj) {
+                        if (V[I[i] + h] < x) {
+                            ++i;
+                        } else if (V[I[i] + h] == x) {
+                            std::swap(I[i], I[jj + j]);
+                            ++j;
+                        } else {
+                            std::swap(I[i], I[kk + k]);
+                            ++k;
+                        }
+                    }
+                    while (jj + j < kk) {
+                        if (V[I[jj + j] + h] == x) {
+                            ++j;
+                        } else {
+                            std::swap(I[jj + j], I[kk + k]);
+                            ++k;
+                        }
+                    }
+
+                    if (jj > start) {
+                        split(start, jj - start, h);
+                    }
+
+                    for (i = 0; i < kk - jj; ++i) {
+                        V[I[jj + i]] = kk - 1;
+                    }
+                    if (jj == kk - 1) {
+                        I[jj] = -1;
+                    }
+
+                    len = start + len - kk;
+                    start = kk;
+                }
+            }
+
+            void split_small(const index_type start, const index_type len, const index_type h) {
+                index_type j = 0;
+                for (index_type k = start; k < start + len; k += j) {
+                    j = 1;
+                    index_type x = V[I[k] + h];
+                    for (index_type i = 1; k + i < start + len; ++i) {
+                        if (V[I[k + i] + h] < x) {
+                            x = V[I[k + i] + h];
+                            j = 0;
+                        }
+                        if (V[I[k + i] + h] == x) {
+                            std::swap(I[k + j], I[k + i]);
+                            ++j;
+                        }
+                    }
+                    for (index_type i = 0; i < j; ++i) {
+                        V[I[k + i]] = k + j - 1;
+                    }
+                    if (j == 1) {
+                        I[k] = -1;
+                    }
+                }
+            }
+
+            std::vector<index_type>& I;
+            std::vector<index_type>& V;
+        };
+
+        std::int64_t match_length(const std::string_view a, const std::string_view b) noexcept {
+            const auto limit = std::min(a.size(), b.size());
+            std::size_t i = 0;
+            while (i < limit && a[i] == b[i]) {
+                ++i;
+            }
+            return static_cast<std::int64_t>(i);
+        }
+
+        /**
+         * @brief 在后缀数组中二分查找与 target 公共前缀最长的 base 后缀
+         */
+        std::int64_t search(const std::vector<index_type>& I, const std::string_view base, const std::string_view target, std::int64_t& pos) noexcept {
+            std::int64_t st = 0;
+            std::int64_t en = static_cast<std::int64_t>(base.size());
+            while (en - st >= 2) {
+                const auto x = st + (en - st) / 2;
+                const auto suffix = base.substr(static_cast<std::size_t>(I[x]));
+                if (std::memcmp(suffix.data(), target.data(), std::min(suffix.size(), target.size())) < 0) {
+                    st = x;
+                } else {
+                    en = x;
+                }
+            }
+
+            const auto x = match_length(base.substr(static_cast<std::size_t>(I[st])), target);
+            const auto y = match_length(base.substr(static_cast<std::size_t>(I[en])), target);
+            pos = x > y ? I[st] : I[en];
+            return std::max(x, y);
+        }
+
+        /**
+         * @brief bsdiff 的主循环，只处理 target 的 [begin, end)，记录追加到 out
+         */
+        void diff_block(const std::vector<index_type>& I, const std::string_view base, const std::string_view target,
+                        const std::int64_t begin, const std::int64_t end, std::string& out) {
+            const auto* old = reinterpret_cast<const unsigned char*>(base.data());
+            const auto* cur = reinterpret_cast<const unsigned char*>(target.data());
+            const auto old_size = static_cast<std::int64_t>(base.size());
+
+            std::int64_t scan = begin;
+            std::int64_t len = 0;
+            std::int64_t pos = 0;
+            // 与 bsdiff 相同，初始假设 target 与 base 在同一偏移处对齐：last_offset 始终等于 last_pos - last_scan
+            std::int64_t last_scan = begin;
+            std::int64_t last_pos = std::min(begin, old_size);
+            std::int64_t last_offset = last_pos - last_scan;
+
+            while (scan < end) {
+                std::int64_t old_score = 0;
+                scan += len;
+                for (std::int64_t scsc = scan; scan < end; ++scan) {
+                    len = search(I, base, target.substr(static_cast<std::size_t>(scan), static_cast<std::size_t>(end - scan)), pos);
+
+                    for (; scsc < scan + len; ++scsc) {
+                        if (scsc + last_offset < old_size && old[scsc + last_offset] == cur[scsc]) {
+                            ++old_score;
+                        }
+                    }
+
+                    if ((len == old_score && len != 0) || len > old_score + 8) {
+                        break;
+                    }
+                    if (scan + last_offset < old_size && old[scan + last_offset] == cur[scan]) {
+                        --old_score;
+                    }
+                }
+
+                if (len == old_score && scan != end) {
+                    continue;
+                }
+
+                // 向前延伸上一个匹配
+                std::int64_t length_forward = 0;
+                {
+                    std::int64_t s = 0;
+                    std::int64_t best = 0;
+                    for (std::int64_t i = 0; last_scan + i < scan && last_pos + i < old_size;) {
+                        if (old[last_pos + i] == cur[last_scan + i]) ++s;
+                        ++i;
+                        if (s * 2 - i > best * 2 - length_forward) {
+                            best = s;
+                            length_forward = i;
+                        }
+                    }
+                }
+
+                // 向后延伸当前匹配
+                std::int64_t length_backward = 0;
+                if (scan < end) {
+                    std::int64_t s = 0;
+                    std::int64_t best = 0;
+                    for (std::int64_t i = 1; scan >= last_scan + i && pos >= i; ++i) {
+                        if (old[pos - i] == cur[scan - i]) ++s;
+                        if (s * 2 - i > best * 2 - length_backward) {
+                            best = s;
+                            length_backward = i;
+                        }
+                    }
+                }
+
+                // 两个延伸重叠时找出最佳分界
+                if (last_scan + length_forward > scan - length_backward) {
+                    const auto overlap = (last_scan + length_forward) - (scan - length_backward);
+                    std::int64_t s = 0;
+                    std::int64_t best = 0;
+                    std::int64_t split = 0;
+                    for (std::int64_t i = 0; i < overlap; ++i) {
+                        if (cur[last_scan + length_forward - overlap + i] == old[last_pos + length_forward - overlap + i]) ++s;
+                        if (cur[scan - length_backward + i] == old[pos - length_backward + i]) --s;
+                        if (s > best) {
+                            best = s;
+                            split = i + 1;
+                        }
+                    }
+                    length_forward += split - overlap;
+                    length_backward -= split;
+                }
+
+                const auto extra_length = (scan - length_backward) - (last_scan + length_forward);
+                if (length_forward > 0 || extra_length > 0) {
+                    put_u64(out, static_cast<std::uint64_t>(length_forward));
+                    put_u64(out, static_cast<std::uint64_t>(extra_length));
+                    put_u64(out, static_cast<std::uint64_t>(last_pos));
+                    for (std::int64_t i = 0; i < length_forward; ++i) {
+                        out.push_back(static_cast<char>(cur[last_scan + i] - old[last_pos + i]));
+                    }
+                    out.append(target.substr(static_cast<std::size_t>(last_scan + length_forward), static_cast<std::size_t>(extra_length)));
+                }
+
+                last_scan = scan - length_backward;
+                last_pos = pos - length_backward;
+                last_offset = pos - scan;
+            }
+        }
+    }
+
+    std::string make_delta(const std::string_view base, const std::string_view target, const delta_options& options) {
+        if (base.size() >= static_cast<std::size_t>(std::numeric_limits<index_type>::max())) {
+            throw std::length_error("delta base too large");
+        }
+
+        std::string out{delta_magic};
+        put_u64(out, base.size());
+        put_u64(out, target.size());
+        if (base.empty()) {
+            if (!target.empty()) {
+                put_u64(out, 0);
+                put_u64(out, target.size());
+                put_u64(out, 0);
+                out.append(target);
+            }
+            return out;
+        }
+
+        const auto size = static_cast<index_type>(base.size());
+        std::vector<index_type> I(base.size() + 1);
+        {
+            std::vector<index_type> V(base.size() + 1);
+            suffix_sorter{I, V}.sort(reinterpret_cast<const unsigned char*>(base.data()), size);
+        }
+
+        // 目标数据切分为连续的块并行扫描，各块的记录按顺序拼接
+        const auto hardware = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+        const auto threads = options.threads ? options.threads : hardware;
+        const auto blocks = std::clamp<std::size_t>(target.size() / std::max<std::size_t>(options.min_block_size, 1), 1, threads);
+        const auto block_size = (target.size() + blocks - 1) / blocks;
+
+        std::vector<std::string> outputs(blocks);
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(blocks - 1);
+            for (std::size_t b = 1; b < blocks; ++b) {
+                workers.emplace_back([&, b] {
+                    const auto begin = b * block_size;
+                    diff_block(I, base, target, static_cast<std::int64_t>(begin),
+                               static_cast<std::int64_t>(std::min(begin + block_size, target.size())), outputs[b]);
+                });
+            }
+            diff_block(I, base, target, 0, static_cast<std::int64_t>(std::min(block_size, target.size())), outputs[0]);
+        }
+
+        for (const auto& block : outputs) {
+            out += block;
+        }
+        return out;
+    }
+
+    std::optional<std::string> apply_delta(const std::string_view base, std::string_view delta) {
+        if (!delta.starts_with(delta_magic)) {
+            return std::nullopt;
+        }
+        delta.remove_prefix(delta_magic.size());
+
+        const auto base_size = get_u64(delta);
+        const auto target_size = get_u64(delta);
+        if (!base_size || !target_size || *base_size != base.size() || *target_size > delta.size()) {
+            return std::nullopt;
+        }
+
+        // 每个输出字节都对应差分中的一个字节，target 大小不会超过剩余的差分长度
+        std::string target;
+        target.reserve(*target_size);
+        while (!delta.empty()) {
+            const auto diff_length = get_u64(delta);
+            const auto extra_length = get_u64(delta);
+            const auto offset = get_u64(delta);
+            if (!diff_length || !extra_length || !offset
+                || *offset > base.size() || *diff_length > base.size() - *offset
+                || *diff_length > delta.size() || *extra_length > delta.size() - *diff_length
+                || *diff_length + *extra_length > *target_size - target.size()) {
+                return std::nullopt;
+            }
+
+            for (std::uint64_t i = 0; i < *diff_length; ++i) {
+                target.push_back(static_cast<char>(static_cast<unsigned char>(delta[i]) + static_cast<unsigned char>(base[*offset + i])));
+            }
+            target.append(delta.substr(*diff_length, *extra_length));
+            delta.remove_prefix(*diff_length + *extra_length);
+        }
+
+        if (target.size() != *target_size) {
+            return std::nullopt;
+        }
+        return target;
+    }
+}
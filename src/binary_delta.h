@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace l2q_http {
+    /**
+     * @brief 差分的生成参数。
+     */
+    struct delta_options {
+        /// 并行扫描目标数据的线程数，0 表示使用硬件线程数
+        std::size_t threads{0};
+        /// 每个线程至少处理的目标数据字节数，块太小时块边界处的匹配损失会变得明显
+        std::size_t min_block_size{4 * 1024 * 1024};
+    };
+
+    /**
+     * @brief 生成从 base 到 target 的二进制差分（bsdiff 算法）。
+     *
+     * 对 base 建立后缀数组（qsufsort），target 被切分为若干块并行扫描，块内按 bsdiff 的方式
+     * 寻找近似匹配，块边界处的匹配在各自的块内截断。
+     *
+     * 差分格式（未压缩，整数均为小端 u64）：
+     * "L2QDIFF1" base 大小 target 大小，之后是若干条记录直到结尾：
+     * diff 长度 extra 长度 base 偏移，diff 长度个字节（与 base 偏移处的数据逐字节相加，模 256），
+     * extra 长度个字节（原样输出）。记录按顺序输出即得到 target。
+     *
+     * @throw std::length_error base 超过 2 GiB
+     */
+    [[nodiscard]]
+    std::string make_delta(std::string_view base, std::string_view target, const delta_options& options = {});
+
+    /**
+     * @brief 将差分应用到 base 上。
+     * @return 重建的 target；差分格式错误或与 base 不符时返回 std::nullopt
+     */
+    [[nodiscard]]
+    std::optional<std::string> apply_delta(std::string_view base, std::string_view delta);
+}
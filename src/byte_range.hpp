@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace l2q_http{
+/**
+ * @brief 闭区间 [first, last] 的字节范围
+ */
+struct byte_range{
+	std::uint64_t first;
+	std::uint64_t last;
+
+	[[nodiscard]] constexpr std::uint64_t length() const noexcept{
+		return last - first + 1;
+	}
+};
+
+// 一个请求最多接受的范围数，超过时忽略 Range 发送完整内容
+inline constexpr std::size_t max_byte_ranges = 16;
+
+/**
+ * @brief 解析 Range 请求头（RFC 7233）
+ * 可满足的范围按起点排序，重叠或相邻的范围合并，避免客户端用大量重叠范围放大响应。
+ * @param header Range 请求头的值，例如 "bytes=0-499, -500"
+ * @param size 内容的总长度
+ * @return 格式错误、单位不是 bytes 或范围过多时返回 std::nullopt（应忽略 Range）；
+ *         没有可满足的范围时返回空数组（416）
+ */
+inline std::optional<std::vector<byte_range>> parse_byte_ranges(std::string_view header, const std::uint64_t size){
+	constexpr std::string_view unit = "bytes=";
+	if(!header.starts_with(unit)) return std::nullopt;
+	header.remove_prefix(unit.size());
+
+	const auto trim = [](std::string_view str){
+		while(!str.empty() && (str.front() == ' ' || str.front() == '\t')) str.remove_prefix(1);
+		while(!str.empty() && (str.back() == ' ' || str.back() == '\t')) str.remove_suffix(1);
+		return str;
+	};
+	const auto parse_number = [](const std::string_view str) -> std::optional<std::uint64_t>{
+		std::uint64_t value = 0;
+		const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+		if(str.empty() || ec != std::errc{} || ptr != str.data() + str.size()) return std::nullopt;
+		return value;
+	};
+
+	std::vector<byte_range> ranges;
+	std::size_t specs = 0;
+	while(!header.empty()){
+		const auto comma = header.find(',');
+		const auto spec = trim(header.substr(0, comma));
+		header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+		if(spec.empty()) continue;
+		if(++specs > max_byte_ranges) return std::nullopt;
+
+		const auto dash = spec.find('-');
+		if(dash == std::string_view::npos) return std::nullopt;
+		const auto first_text = trim(spec.substr(0, dash));
+		const auto last_text = trim(spec.substr(dash + 1));
+
+		if(first_text.empty()){
+			// 后缀范围 "-N"：最后 N 个字节
+			const auto suffix = parse_number(last_text);
+			if(!suffix) return std::nullopt;
+			if(*suffix != 0 && size != 0){
+				ranges.push_back({size - std::min(*suffix, size), size - 1});
+			}
+			continue;
+		}
+
+		const auto first = parse_number(first_text);
+		if(!first) return std::nullopt;
+		std::uint64_t last = size - 1;
+		if(!last_text.empty()){
+			const auto parsed = parse_number(last_text);
+			if(!parsed || *parsed < *first) return std::nullopt;
+			last = std::min(*parsed, size - 1);
+		}
+		if(*first < size){
+			ranges.push_back({*first, last});
+		}
+	}
+	if(specs == 0) return std::nullopt;
+
+	std::ranges::sort(ranges, {}, &byte_range::first);
+	std::vector<byte_range> merged;
+	for(const auto& range : ranges){
+		if(!merged.empty() && range.first <= merged.back().last + 1){
+			merged.back().last = std::max(merged.back().last, range.last);
+		} else{
+			merged.push_back(range);
+		}
+	}
+	return merged;
+}
+} // namespace l2q_http
@@ -0,0 +1,141 @@
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include "heterogeneous.hpp"
+
+/**
+ * @brief 发布目录的二进制镜像格式
+ * 清单（JSON）仍是编写发布记录的格式，服务把解析、入库后的结果编译成一个扁平的镜像文件，
+ * 下次启动时直接映射到内存使用，不再解析 JSON、不再计算清单摘要、不再逐个查询更新包的入库记录。
+ *
+ * 布局（本机字节序，各段按 8 字节对齐，偏移量相对于文件起始）：
+ *   header
+ *   track_entry[track_count]            每个 (os-arch, channel) 在下面数组中的范围
+ *   packed_version[release_count]       按 (os-arch, channel, 版本) 升序，check_version 直接在其上二分查找
+ *   uint8_t pending_flags[release_count]
+ *   release_record[release_count]
+ *   char strings[]                      字符串表，相同的字符串只保存一份
+ */
+namespace l2q_http::catalog_image{
+	inline constexpr std::array<char, 8> magic{'L', '2', 'Q', 'C', 'A', 'T', 'L', 'G'};
+	// 布局变化时递增，旧版本的镜像会被忽略并重新编译
+	inline constexpr std::uint32_t format_version = 1;
+	// 以写入方的字节序保存，读取时不一致即视为不兼容
+	inline constexpr std::uint32_t byte_order_mark = 0x0102'0304;
+
+	struct header{
+		std::array<char, 8> magic;
+		std::uint32_t version;
+		std::uint32_t byte_order;
+		std::uint64_t file_size;
+		// 文件头之后所有字节的 CRC-32
+		std::uint32_t checksum;
+		std::uint32_t track_count;
+		std::uint64_t release_count;
+		// 编译时清单文件内容的 SHA-256，与当前清单不一致时镜像已过期
+		std::array<std::uint8_t, 32> manifest_digest;
+		// catalog_snapshot::fingerprint，实体标签与从 JSON 加载时相同
+		std::uint64_t fingerprint;
+		std::uint64_t tracks_offset;
+		std::uint64_t versions_offset;
+		std::uint64_t flags_offset;
+		std::uint64_t records_offset;
+		std::uint64_t strings_offset;
+		std::uint64_t strings_size;
+	};
+
+	struct track_entry{
+		std::uint32_t first;
+		std::uint32_t count;
+	};
+
+	// 字符串表中的一段
+	struct string_ref{
+		std::uint32_t offset;
+		std::uint32_t length;
+	};
+
+	/**
+	 * @brief 更新包源文件的修改时间（纳秒）与大小，加载镜像时与文件系统比较，源文件被替换后镜像即过期
+	 */
+	struct source_stamp{
+		std::int64_t mtime;
+		std::uint64_t size;
+
+		friend bool operator==(const source_stamp&, const source_stamp&) = default;
+	};
+
+	struct release_record{
+		std::uint64_t size;
+		std::uint64_t compressed_size;
+		source_stamp source;
+		std::array<std::uint8_t, 32> sha256;
+		string_ref version_string;
+		string_ref package;
+		string_ref object;
+		std::uint8_t flags;
+		// 是否已入库；未入库的发布加载时要求源文件仍不存在
+		std::uint8_t stored;
+		std::array<std::uint8_t, 6> reserved;
+	};
+
+	static_assert(sizeof(header) % 8 == 0 && sizeof(release_record) == 96 && alignof(release_record) == 8);
+
+	constexpr std::uint64_t align(const std::uint64_t offset) noexcept{
+		return (offset + 7) & ~std::uint64_t{7};
+	}
+
+	/**
+	 * @brief 源文件当前的状态，不存在或不是普通文件时返回 std::nullopt
+	 */
+	inline std::optional<source_stamp> stamp(const std::filesystem::path& path) noexcept{
+		struct stat st{};
+		if(::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)){
+			return std::nullopt;
+		}
+#if defined(__APPLE__)
+		const auto& modified = st.st_mtimespec;
+#else
+		const auto& modified = st.st_mtim;
+#endif
+		return source_stamp{static_cast<std::int64_t>(modified.tv_sec) * 1'000'000'000 + modified.tv_nsec, static_cast<std::uint64_t>(st.st_size)};
+	}
+
+	/**
+	 * @brief 编译镜像时使用的字符串表
+	 */
+	class string_table{
+	public:
+		string_ref intern(const std::string_view string){
+			if(const auto* existing = refs_.try_find(string)){
+				return *existing;
+			}
+			if(data_.size() + string.size() > UINT32_MAX){
+				throw std::length_error("catalog image: string table too large");
+			}
+			const string_ref ref{static_cast<std::uint32_t>(data_.size()), static_cast<std::uint32_t>(string.size())};
+			data_.append(string);
+			refs_.insert_or_assign(string, ref);
+			return ref;
+		}
+
+		[[nodiscard]] const std::string& data() const noexcept{
+			return data_;
+		}
+
+	private:
+		std::string data_;
+		string_hash_map<string_ref> refs_;
+	};
+} // namespace l2q_http::catalog_image
+
+#endif
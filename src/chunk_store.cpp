@@ -0,0 +1,196 @@
+#include "chunk_store.h"
+
+#include "atomic_file.hpp"
+#include "compress.h"
+#include "sha256.h"
+#include <array>
+#include <bit>
+#include <fstream>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+
+namespace l2q_http {
+    namespace {
+        // Gear 表：256 个固定的伪随机数（splitmix64），分块结果在不同版本的服务之间保持一致
+        constexpr auto gear_table = [] {
+            std::array<std::uint64_t, 256> table{};
+            std::uint64_t state = 0x4c3251434443ull;
+            for (auto& value : table) {
+                state += 0x9e3779b97f4a7c15ull;
+                auto z = state;
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                value = z ^ (z >> 31);
+            }
+            return table;
+        }();
+
+        // 取哈希的高位：Gear 哈希的第 k 位只取决于最近 k + 1 个字节，高位覆盖的窗口最大
+        constexpr std::uint64_t high_bits_mask(const int bits) noexcept {
+            return bits <= 0 ? 0 : ~std::uint64_t{0} << (64 - bits);
+        }
+
+        bool is_sha256_hex(const std::string_view value) noexcept {
+            if (value.size() != 64) {
+                return false;
+            }
+            for (const char c : value) {
+                if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    std::size_t find_chunk_boundary(const std::string_view data, const chunking_params& params) noexcept {
+        const auto size = std::min(data.size(), params.max_size);
+        if (size <= params.min_size) {
+            return size;
+        }
+
+        // 归一化分块：平均大小之前用更严格的掩码（多 2 位），之后用更宽松的掩码（少 2 位）
+        const int bits = std::countr_zero(params.average_size);
+        const auto strict_mask = high_bits_mask(bits + 2);
+        const auto loose_mask = high_bits_mask(bits - 2);
+        const auto normal = std::min(params.average_size, size);
+        const auto* bytes = reinterpret_cast<const unsigned char*>(data.data());
+
+        std::uint64_t hash = 0;
+        std::size_t i = params.min_size;
+        for (; i < normal; ++i) {
+            hash = (hash << 1) + gear_table[bytes[i]];
+            if (!(hash & strict_mask)) {
+                return i + 1;
+            }
+        }
+        for (; i < size; ++i) {
+            hash = (hash << 1) + gear_table[bytes[i]];
+            if (!(hash & loose_mask)) {
+                return i + 1;
+            }
+        }
+        return size;
+    }
+
+    chunk_store::chunk_store(std::filesystem::path root, const chunking_params& params) : root_(std::move(root)), params_(params) {
+        if (!std::has_single_bit(params_.average_size) || params_.min_size >= params_.average_size || params_.average_size >= params_.max_size) {
+            throw std::invalid_argument("invalid chunking parameters");
+        }
+        std::filesystem::create_directories(root_ / "chunks");
+        std::filesystem::create_directories(root_ / "manifests");
+    }
+
+    std::shared_ptr<const chunk_manifest> chunk_store::add(const package_info& package, const package_store& packages) {
+        if (auto existing = manifest(package.sha256)) {
+            return existing;
+        }
+        if (auto loaded = load_manifest(package.sha256)) {
+            std::lock_guard lock(mutex_);
+            return manifests_.try_emplace(package.sha256, std::move(loaded)).first->second;
+        }
+
+        const auto data = packages.read(package);
+        auto result = std::make_shared<chunk_manifest>();
+        result->package = package.sha256;
+        result->size = data.size();
+
+        std::string_view rest = data;
+        while (!rest.empty()) {
+            const auto chunk = rest.substr(0, find_chunk_boundary(rest, params_));
+            rest.remove_prefix(chunk.size());
+
+            auto digest = sha256::to_hex(sha256::hash(chunk));
+            const auto path = chunk_path(digest);
+            if (std::error_code ec; std::filesystem::exists(path, ec)) {
+                chunks_deduplicated_.fetch_add(1, std::memory_order_relaxed);
+                bytes_deduplicated_.fetch_add(chunk.size(), std::memory_order_relaxed);
+            } else {
+                const auto compressed = gzip_compress(chunk, 9);
+                if (!compressed) {
+                    throw std::runtime_error("failed to compress chunk");
+                }
+                std::filesystem::create_directories(path.parent_path());
+                write_file_atomic(path, *compressed);
+                chunks_written_.fetch_add(1, std::memory_order_relaxed);
+                bytes_written_.fetch_add(chunk.size(), std::memory_order_relaxed);
+            }
+            result->chunks.push_back({std::move(digest), chunk.size()});
+        }
+
+        // 块全部落盘之后才写块列表，读取方看到块列表时所有块都已存在
+        save_manifest(*result);
+        spdlog::info("package sha256:{} split into {} chunks", package.sha256, result->chunks.size());
+
+        std::lock_guard lock(mutex_);
+        return manifests_.try_emplace(package.sha256, std::move(result)).first->second;
+    }
+
+    std::shared_ptr<const chunk_manifest> chunk_store::manifest(const std::string_view package) const {
+        std::lock_guard lock(mutex_);
+        const auto* found = manifests_.try_find(package);
+        return found ? *found : nullptr;
+    }
+
+    std::optional<std::filesystem::path> chunk_store::chunk_object(const std::string_view sha256) const {
+        // 摘要会拼进文件路径，只接受 64 位小写十六进制，防止路径穿越
+        if (!is_sha256_hex(sha256)) {
+            return std::nullopt;
+        }
+        auto path = chunk_path(sha256);
+        if (std::error_code ec; !std::filesystem::is_regular_file(path, ec)) {
+            return std::nullopt;
+        }
+        return path;
+    }
+
+    nlohmann::json chunk_store::metrics() const {
+        std::size_t manifests = 0;
+        {
+            std::lock_guard lock(mutex_);
+            manifests = manifests_.size();
+        }
+        return {
+            {"packages", manifests},
+            {"chunks_written", chunks_written_.load(std::memory_order_relaxed)},
+            {"chunks_deduplicated", chunks_deduplicated_.load(std::memory_order_relaxed)},
+            {"bytes_written", bytes_written_.load(std::memory_order_relaxed)},
+            {"bytes_deduplicated", bytes_deduplicated_.load(std::memory_order_relaxed)},
+        };
+    }
+
+    std::shared_ptr<const chunk_manifest> chunk_store::load_manifest(const std::string& package) const {
+        std::ifstream file(root_ / "manifests" / (package + ".json"));
+        if (!file) {
+            return nullptr;
+        }
+
+        try {
+            const auto json = nlohmann::json::parse(file);
+            auto result = std::make_shared<chunk_manifest>();
+            result->package = package;
+            result->size = json.at("size").get<std::uint64_t>();
+            for (const auto& chunk : json.at("chunks")) {
+                result->chunks.push_back({chunk.at("sha256").get<std::string>(), chunk.at("size").get<std::uint64_t>()});
+            }
+            return result;
+        } catch (const std::exception& e) {
+            // 块列表可以重新生成，损坏时当作不存在
+            spdlog::warn("ignoring corrupt chunk manifest for sha256:{}: {}", package, e.what());
+            return nullptr;
+        }
+    }
+
+    void chunk_store::save_manifest(const chunk_manifest& manifest) const {
+        auto chunks = nlohmann::json::array();
+        for (const auto& chunk : manifest.chunks) {
+            chunks.push_back({{"sha256", chunk.sha256}, {"size", chunk.size}});
+        }
+
+        write_file_atomic(root_ / "manifests" / (manifest.package + ".json"), nlohmann::json{{"size", manifest.size}, {"chunks", std::move(chunks)}}.dump());
+    }
+
+    std::filesystem::path chunk_store::chunk_path(const std::string_view sha256) const {
+        return root_ / "chunks" / sha256.substr(0, 2) / (std::string{sha256} + ".gz");
+    }
+}
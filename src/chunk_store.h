@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "heterogeneous.hpp"
+#include "package_store.h"
+
+namespace l2q_http {
+    /**
+     * @brief 内容定义分块的参数，单位为字节。
+     */
+    struct chunking_params {
+        std::size_t min_size{16 * 1024};
+        /// 期望的平均块大小，必须是 2 的幂
+        std::size_t average_size{64 * 1024};
+        std::size_t max_size{256 * 1024};
+    };
+
+    /**
+     * @brief 用 FastCDC 算法在 data 中寻找第一个块的边界。
+     *
+     * Gear 滚动哈希只取决于最近 64 个字节，边界由内容决定：在数据中插入或删除字节只会改变附近的块，
+     * 之后的块边界保持不变。使用归一化分块，块大小集中在平均值附近。
+     *
+     * @return 第一个块的长度，data 为空时返回 0
+     */
+    [[nodiscard]]
+    std::size_t find_chunk_boundary(std::string_view data, const chunking_params& params = {}) noexcept;
+
+    /**
+     * @brief 更新包分块后的结果。
+     */
+    struct chunk_manifest {
+        struct chunk {
+            /// 块原始数据的 SHA-256 小写十六进制
+            std::string sha256;
+            std::uint64_t size{};
+        };
+
+        /// 更新包原始数据的 SHA-256
+        std::string package;
+        std::uint64_t size{};
+        std::vector<chunk> chunks;
+    };
+
+    /**
+     * @brief 按内容分块去重的存储。
+     *
+     * 更新包按 find_chunk_boundary 切分，每个块以其 SHA-256 命名、Gzip 压缩后保存在 root/chunks/xx/<sha256>.gz，
+     * 多个版本或多个 os-arch 中相同的块只保存一份；更新包的块列表保存在 root/manifests/<sha256>.json。
+     * 客户端取得块列表后只需下载本地没有的块，按顺序拼接即得到更新包。
+     *
+     * 可被多个线程同时调用。
+     */
+    class chunk_store {
+    public:
+        /**
+         * @throw std::filesystem::filesystem_error 无法创建存储目录
+         */
+        explicit chunk_store(std::filesystem::path root, const chunking_params& params = {});
+
+        /**
+         * @brief 将更新包分块入库，已分块的直接返回记录（之前运行时保存的块列表在这里从磁盘载入）
+         * 启动与发布时对每个最新的更新包调用，之后 manifest 只需查找内存
+         * @throw std::runtime_error 读取或写入失败
+         */
+        std::shared_ptr<const chunk_manifest> add(const package_info& package, const package_store& packages);
+
+        /**
+         * @brief 查找已入库更新包的块列表，只查内存，不读取磁盘，可以在事件循环上调用
+         */
+        [[nodiscard]] std::shared_ptr<const chunk_manifest> manifest(std::string_view package) const;
+
+        /**
+         * @brief 块对象的路径，sha256 格式错误或块不存在时返回 std::nullopt
+         */
+        [[nodiscard]] std::optional<std::filesystem::path> chunk_object(std::string_view sha256) const;
+
+        /**
+         * @brief 自启动以来新写入的块与因去重而跳过的块的数量和字节数（压缩前）
+         */
+        [[nodiscard]] nlohmann::json metrics() const;
+
+    private:
+        std::shared_ptr<const chunk_manifest> load_manifest(const std::string& package) const;
+        void save_manifest(const chunk_manifest& manifest) const;
+        std::filesystem::path chunk_path(std::string_view sha256) const;
+
+        std::filesystem::path root_;
+        chunking_params params_;
+
+        mutable std::mutex mutex_;
+        string_hash_map<std::shared_ptr<const chunk_manifest>> manifests_;
+
+        std::atomic<std::uint64_t> chunks_written_{0};
+        std::atomic<std::uint64_t> chunks_deduplicated_{0};
+        std::atomic<std::uint64_t> bytes_written_{0};
+        std::atomic<std::uint64_t> bytes_deduplicated_{0};
+    };
+}
@@ -2,17 +2,10 @@
 
 #include <vector>
 #include <limits>
-#include <limits>
 #include <utility>
 #include <algorithm>
 #include <zlib.h>
 
-#if defined(__has_cpp_attribute) && __has_cpp_attribute(indeterminate)
-#  define BUFFER_INDETERMINATE [[indeterminate]]
-#else
-#  define BUFFER_INDETERMINATE
-#endif
-
 namespace {
     // 内部辅助：自动管理 z_stream 资源的 RAII 包装器
     struct ZStreamGuard {
@@ -28,119 +21,312 @@ namespace {
             }
         }
     };
-}
 
-std::optional<std::string> gzip_compress(std::string_view data, int level) noexcept try{
-    if (data.empty()) {
-        return std::string{};
-    }
+    // 无法信任 ISIZE 时的初始预分配上限
+    constexpr std::size_t initial_inflate_reserve = 256 * 1024;
 
-    // 限制压缩级别范围
-    if (level != -1) {
-        level = std::clamp(level, 0, 9);
+    /**
+     * @brief 读取 Gzip 尾部的 ISIZE（原始数据长度 mod 2^32），并判断其是否可信。
+     *
+     * ISIZE 由发送方填写，可以伪造，所以仅在以下条件都满足时才采信：
+     * - 不超过调用方给出的上限；
+     * - 不超过 deflate 理论最大压缩比（约 1032:1）；
+     * - 不小于存储块（不压缩）时的下限，否则说明尾部与数据不符或存在多个 member。
+     */
+    std::optional<std::size_t> gzip_trusted_isize(std::string_view data, std::size_t cap) noexcept {
+        // 10 字节头部 + 8 字节尾部
+        constexpr std::size_t gzip_overhead = 18;
+        if (data.size() < gzip_overhead) {
+            return std::nullopt;
+        }
+
+        const auto* tail = reinterpret_cast<const unsigned char*>(data.data() + data.size() - 4);
+        const std::size_t isize =
+            static_cast<std::size_t>(tail[0])
+            | static_cast<std::size_t>(tail[1]) << 8
+            | static_cast<std::size_t>(tail[2]) << 16
+            | static_cast<std::size_t>(tail[3]) << 24;
+
+        if (isize > cap || isize / 1032 > data.size()) {
+            return std::nullopt;
+        }
+
+        // 存储块每 65535 字节附加 5 字节，另外头部可能携带文件名等可选字段，这里留出余量
+        const std::size_t stored_size = isize + (isize / 65535 + 1) * 5 + gzip_overhead;
+        if (data.size() > stored_size + 1024) {
+            return std::nullopt;
+        }
+
+        return isize;
     }
 
-    z_stream zs{};
+    /**
+     * @brief deflate 压缩核心，按 deflateBound 向 provider 请求一次输出空间。
+     * @param window_bits 15 + 16 为 Gzip 格式，15 为 zlib 格式
+     * @param dictionary 预置字典，仅 zlib 格式可用
+     */
+    std::optional<std::size_t> deflate_to(std::string_view data, int level, int window_bits, std::string_view dictionary,
+                                          void* context, detail::gzip_output_provider provider) noexcept try{
+        // 限制压缩级别范围
+        if (level != -1) {
+            level = std::clamp(level, 0, 9);
+        }
 
-    // 15 + 16 启用 Gzip 头部处理
-    if (deflateInit2(&zs, level, Z_DEFLATED, 15 | 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        // zlib 使用 uInt，确保 size 不溢出
+        if (data.size() > std::numeric_limits<uInt>::max()) {
+             return std::nullopt;
+        }
+
+        z_stream zs{};
+
+        if (deflateInit2(&zs, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return std::nullopt;
+        }
+
+        ZStreamGuard guard(zs, true);
+
+        if (!dictionary.empty() &&
+            deflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(dictionary.data()), static_cast<uInt>(dictionary.size())) != Z_OK) {
+            return std::nullopt;
+        }
+
+        zs.next_in = reinterpret_cast<const Bytef*>(data.data());
+        zs.avail_in = static_cast<uInt>(data.size());
+
+        // 一次性按上界取得输出空间，Z_FINISH 下 deflate 保证一次完成
+        const std::span<std::byte> out = provider(context, deflateBound(&zs, static_cast<uLong>(data.size())));
+
+        std::size_t written = 0;
+        int ret;
+
+        do {
+            if (written == out.size()) {
+                // 调用方提供的空间不足
+                return std::nullopt;
+            }
+
+            const auto avail = static_cast<uInt>(std::min<std::size_t>(out.size() - written, std::numeric_limits<uInt>::max()));
+            zs.next_out = reinterpret_cast<Bytef*>(out.data() + written);
+            zs.avail_out = avail;
+
+            ret = deflate(&zs, Z_FINISH);
+
+            written += avail - zs.avail_out;
+        } while (ret == Z_OK);
+
+        if (ret != Z_STREAM_END) {
+            return std::nullopt;
+        }
+
+        return written;
+    } catch(...){
         return std::nullopt;
     }
 
-    ZStreamGuard guard(zs, true);
+    /**
+     * @brief 有界 inflate 核心，直接解压到 out 中。
+     * @param window_bits 15 + 16 为 Gzip 格式，15 为 zlib 格式
+     * @param dictionary 流要求预置字典时使用的字典
+     */
+    inflate_status inflate_bounded(std::string_view compressed_data, const inflate_limits& limits, int window_bits,
+                                   std::string_view dictionary, std::string& out) noexcept try{
+        out.clear();
+        if (compressed_data.empty()) {
+            return inflate_status::ok;
+        }
 
-    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
-    // zlib 使用 uInt，确保 size 不溢出
-    if (data.size() > std::numeric_limits<uInt>::max()) {
-         return std::nullopt;
-    }
-    zs.avail_in = static_cast<uInt>(data.size());
+        if (compressed_data.size() > std::numeric_limits<uInt>::max()) {
+            return inflate_status::invalid_data;
+        }
 
-    int ret;
-    char buffer[32 * 1024] BUFFER_INDETERMINATE;
-    std::string compressed_data;
+        // 实际生效的上限取 max_output_size 与 max_ratio * 输入大小 中较小者，并记录触发的是哪一个
+        std::size_t cap = limits.max_output_size;
+        inflate_status cap_status = inflate_status::output_limit_exceeded;
+        if (limits.max_ratio != 0) {
+            const std::size_t ratio_cap =
+                compressed_data.size() > std::numeric_limits<std::size_t>::max() / limits.max_ratio
+                    ? std::numeric_limits<std::size_t>::max()
+                    : compressed_data.size() * limits.max_ratio;
+            if (ratio_cap < cap) {
+                cap = ratio_cap;
+                cap_status = inflate_status::ratio_limit_exceeded;
+            }
+        }
+        // 下面按 cap + 1 分配以探测超限，"不限制"（SIZE_MAX）时避免溢出为 0
+        cap = std::min(cap, out.max_size() - 1);
 
-    // 预估大小：通常压缩后会变小，但对于极小数据或随机数据可能会变大。
-    // 保守估计预分配一部分，避免初期多次 realloc
-    compressed_data.reserve(data.size() / 2);
+        z_stream zs{};
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed_data.data()));
+        zs.avail_in = static_cast<uInt>(compressed_data.size());
 
-    do {
-        zs.next_out = reinterpret_cast<Bytef*>(buffer);
-        zs.avail_out = sizeof(buffer);
+        if (inflateInit2(&zs, window_bits) != Z_OK) {
+            return inflate_status::out_of_memory;
+        }
+
+        ZStreamGuard guard(zs, false); // RAII 自动调用 inflateEnd
 
-        ret = deflate(&zs, Z_FINISH);
+        // 预分配：ISIZE 可信时精确分配，否则从较小的值开始按倍数增长。
+        // 多分配 1 字节用于探测"恰好超过上限"的情况
+        const auto isize = window_bits & 16 ? gzip_trusted_isize(compressed_data, cap) : std::nullopt;
+        std::size_t capacity = isize.value_or(
+            std::min<std::size_t>(compressed_data.size() * 2, initial_inflate_reserve));
+        capacity = std::min(std::max<std::size_t>(capacity, 1), cap + 1);
 
-        if (compressed_data.size() < zs.total_out) {
-            // 计算本次输出产生的数据量
-            // total_out 是累计值，减去当前字符串长度即为新增量
-            // 或者使用 (sizeof(buffer) - zs.avail_out)
-            std::size_t size_produced = sizeof(buffer) - zs.avail_out;
-            compressed_data.append(buffer, size_produced);
+        try {
+            out.resize(capacity);
+        } catch (...) {
+            return inflate_status::out_of_memory;
         }
-    } while (ret == Z_OK);
 
-    if (ret != Z_STREAM_END) {
-        return std::nullopt;
+        std::size_t produced = 0;
+        int ret;
+
+        do {
+            if (produced == out.size()) {
+                if (out.size() > cap) {
+                    return cap_status;
+                }
+                try {
+                    out.resize(std::min(out.size() * 2, cap + 1));
+                } catch (...) {
+                    return inflate_status::out_of_memory;
+                }
+            }
+
+            // 直接解压到输出字符串尾部，不经过中间缓冲区
+            const auto avail = static_cast<uInt>(std::min<std::size_t>(out.size() - produced, std::numeric_limits<uInt>::max()));
+            zs.next_out = reinterpret_cast<Bytef*>(out.data() + produced);
+            zs.avail_out = avail;
+
+            ret = inflate(&zs, Z_NO_FLUSH);
+
+            if (ret == Z_NEED_DICT && !dictionary.empty()) {
+                // 字典与流头部的 DICTID 不符时返回 Z_DATA_ERROR
+                ret = inflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(dictionary.data()), static_cast<uInt>(dictionary.size()));
+                if (ret != Z_OK) {
+                    return inflate_status::invalid_data;
+                }
+                continue;
+            }
+
+            switch (ret) {
+                case Z_NEED_DICT:
+                case Z_DATA_ERROR:
+                case Z_STREAM_ERROR:
+                    return inflate_status::invalid_data;
+                case Z_MEM_ERROR:
+                    return inflate_status::out_of_memory;
+                case Z_BUF_ERROR:
+                    // 输出空间充足却无法前进：输入被截断
+                    if (zs.avail_out != 0) {
+                        return inflate_status::invalid_data;
+                    }
+                    break;
+                default: break;
+            }
+
+            produced += avail - zs.avail_out;
+            if (produced > cap) {
+                return cap_status;
+            }
+        } while (ret != Z_STREAM_END);
+
+        out.resize(produced);
+        return inflate_status::ok;
+    } catch(...){
+        return inflate_status::out_of_memory;
     }
+}
 
-    return compressed_data;
-} catch(...){
-    return std::nullopt;
+std::size_t gzip_compress_bound(const std::size_t size) noexcept {
+    // windowBits = 15, memLevel = 8 时 deflateBound 的计算方式，10 字节头部 + 8 字节尾部
+    return size + (size >> 12) + (size >> 14) + (size >> 25) + 7 + 18;
+}
+
+std::optional<std::size_t> detail::gzip_compress_to(std::string_view data, int level, void* context, gzip_output_provider provider) noexcept {
+    // 15 + 16 启用 Gzip 头部处理
+    return deflate_to(data, level, 15 | 16, {}, context, provider);
 }
 
-std::optional<std::string> gzip_decompress(std::string_view compressed_data) noexcept try{
-    if (compressed_data.empty()) {
-        return std::string{};
+std::optional<std::size_t> gzip_compress(std::string_view data, std::span<std::byte> out, int level) noexcept {
+    if (data.empty()) {
+        return 0;
     }
 
-    z_stream zs{};
-    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed_data.data()));
+    return detail::gzip_compress_to(data, level, &out, [](void* p, std::size_t) {
+        return *static_cast<std::span<std::byte>*>(p);
+    });
+}
 
-    if (compressed_data.size() > std::numeric_limits<uInt>::max()) {
-        return std::nullopt;
+std::optional<std::string> gzip_compress(std::string_view data, int level) noexcept try{
+    std::string compressed_data;
+    if (data.empty()) {
+        return compressed_data;
     }
-    zs.avail_in = static_cast<uInt>(compressed_data.size());
 
-    // 15 + 16 自动检测 zlib 或 gzip 头部
-    if (inflateInit2(&zs, 15 | 16) != Z_OK) {
+    if (!gzip_compress(data, compressed_data, level)) {
         return std::nullopt;
     }
 
-    ZStreamGuard guard(zs, false); // RAII 自动调用 inflateEnd
+    // 缓冲区按 deflateBound 分配，通常远大于压缩结果；返回的字符串可能被长期持有，释放多余的容量
+    compressed_data.shrink_to_fit();
+    return compressed_data;
+} catch(...){
+    return std::nullopt;
+}
 
-    int ret;
-    char buffer[32 * 1024] BUFFER_INDETERMINATE;
-    std::string out_string;
+inflate_status gzip_decompress(std::string_view compressed_data, const inflate_limits& limits, std::string& out) noexcept {
+    // 15 + 16 只接受 gzip 头部
+    return inflate_bounded(compressed_data, limits, 15 | 16, {}, out);
+}
 
-    // 启发式预分配：假设压缩比为 2:1 到 3:1 之间
-    // 如果文件很大，这可以显著减少 realloc
-    // 注意检查 max_size 以防溢出
-    try {
-        out_string.reserve(std::min<size_t>(compressed_data.size() * 3, 1024 * 1024 * 100));
-    } catch (...) {
-        // 内存不足时不强求 reserve，继续尝试
+std::optional<std::string> gzip_decompress(std::string_view compressed_data) noexcept {
+    std::string out;
+    if (gzip_decompress(compressed_data, inflate_limits{}, out) != inflate_status::ok) {
+        return std::nullopt;
     }
+    return out;
+}
 
-    do {
-        zs.next_out = reinterpret_cast<Bytef*>(buffer);
-        zs.avail_out = sizeof(buffer);
-
-        ret = inflate(&zs, Z_NO_FLUSH);
+std::string_view to_string(const inflate_status status) noexcept {
+    switch (status) {
+        case inflate_status::ok: return "ok";
+        case inflate_status::invalid_data: return "invalid gzip data";
+        case inflate_status::output_limit_exceeded: return "decompressed size exceeds limit";
+        case inflate_status::ratio_limit_exceeded: return "compression ratio exceeds limit";
+        case inflate_status::out_of_memory: return "out of memory";
+    }
+    return "unknown";
+}
 
-        switch (ret) {
-            case Z_NEED_DICT:
-            case Z_DATA_ERROR:
-            case Z_MEM_ERROR:
-                return std::nullopt;
-            default: break;
-        }
+std::optional<std::string> deflate_compress(std::string_view data, std::string_view dictionary, int level) noexcept try{
+    if (dictionary.size() > std::numeric_limits<uInt>::max()) {
+        return std::nullopt;
+    }
 
-        std::size_t size_produced = sizeof(buffer) - zs.avail_out;
-        out_string.append(buffer, size_produced);
+    std::string compressed_data;
+    const auto written = deflate_to(data, level, 15, dictionary, &compressed_data, [](void* p, std::size_t bound) -> std::span<std::byte> {
+        auto& buffer = *static_cast<std::string*>(p);
+        buffer.resize(bound);
+        return {reinterpret_cast<std::byte*>(buffer.data()), bound};
+    });
 
-    } while (ret != Z_STREAM_END);
+    if (!written) {
+        return std::nullopt;
+    }
 
-    return out_string;
+    compressed_data.resize(*written);
+    compressed_data.shrink_to_fit();
+    return compressed_data;
 } catch(...){
     return std::nullopt;
 }
+
+inflate_status deflate_decompress(std::string_view compressed_data, std::string_view dictionary, const inflate_limits& limits, std::string& out) noexcept {
+    if (dictionary.size() > std::numeric_limits<uInt>::max()) {
+        return inflate_status::invalid_data;
+    }
+
+    // 15 只接受 zlib 头部
+    return inflate_bounded(compressed_data, limits, 15, dictionary, out);
+}
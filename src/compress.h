@@ -1,25 +1,179 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <concepts>
+#include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <optional>
 
+/**
+ * @brief 有界解压的结果状态。
+ */
+enum struct inflate_status : std::uint8_t {
+    ok,
+    invalid_data,          ///< 数据损坏、截断或不是合法的 Gzip 流
+    output_limit_exceeded, ///< 解压后的数据超过 inflate_limits::max_output_size
+    ratio_limit_exceeded,  ///< 解压比超过 inflate_limits::max_ratio（疑似解压炸弹）
+    out_of_memory,
+};
+
+/**
+ * @brief 解压输出上限，用于防御解压炸弹。
+ */
+struct inflate_limits {
+    /// 解压后允许的最大字节数
+    std::size_t max_output_size{64 * 1024 * 1024};
+    /// 解压后大小 / 压缩数据大小 的最大比值，0 表示不限制
+    std::size_t max_ratio{256};
+};
+
+/**
+ * @brief 获取解压状态的描述文本，用于日志与错误响应。
+ */
+[[nodiscard]]
+std::string_view to_string(inflate_status status) noexcept;
+
+/**
+ * @brief 可按需扩容的字节缓冲区，例如 std::string、std::vector<std::byte>、池化的响应缓冲区。
+ */
+template <typename Buf>
+concept growable_byte_buffer = requires(Buf& buf, std::size_t n){
+    typename Buf::value_type;
+    buf.resize(n);
+    { buf.data() } -> std::convertible_to<const typename Buf::value_type*>;
+    { buf.size() } -> std::convertible_to<std::size_t>;
+} && sizeof(typename Buf::value_type) == 1;
+
+namespace detail {
+    /**
+     * @brief 输出空间提供者：传入 deflateBound 给出的上界，返回可写入的区域。
+     */
+    using gzip_output_provider = std::span<std::byte>(*)(void* context, std::size_t bound);
+
+    /**
+     * @brief 压缩核心实现，向 provider 请求一次输出空间后由 zlib 直接写入。
+     * @return 写入的字节数，失败（包括空间不足）返回 std::nullopt。
+     */
+    [[nodiscard]]
+    std::optional<std::size_t> gzip_compress_to(std::string_view data, int level, void* context, gzip_output_provider provider) noexcept;
+}
+
+/**
+ * @brief 使用默认参数压缩 size 字节时 Gzip 输出的上界（与 deflateBound 一致）。
+ */
+[[nodiscard]]
+std::size_t gzip_compress_bound(std::size_t size) noexcept;
+
+/**
+ * @brief 使用 Gzip 格式将数据直接压缩到调用方提供的内存中。
+ *
+ * @param data 要压缩的原始数据。
+ * @param out 输出区域，大小不小于 gzip_compress_bound(data.size()) 时保证成功。
+ * @param level 压缩级别 (0-9)，默认为 -1 (Z_DEFAULT_COMPRESSION)。
+ * @return std::optional<std::size_t> 成功时返回写入 out 的字节数，失败或空间不足返回 std::nullopt。
+ */
+[[nodiscard]]
+std::optional<std::size_t> gzip_compress(std::string_view data, std::span<std::byte> out, int level = -1) noexcept;
+
+/**
+ * @brief 使用 Gzip 格式压缩数据并追加到可扩容缓冲区末尾。
+ *
+ * 缓冲区只按 deflateBound 扩容一次，压缩完成后截断到实际大小，zlib 直接写入目标内存。
+ *
+ * @param data 要压缩的原始数据。
+ * @param out 输出缓冲区，原有内容保留，失败时恢复原大小。
+ * @param level 压缩级别 (0-9)，默认为 -1 (Z_DEFAULT_COMPRESSION)。
+ * @return 是否成功。
+ */
+template <growable_byte_buffer Buf>
+[[nodiscard]]
+bool gzip_compress(std::string_view data, Buf& out, int level = -1) noexcept {
+    if (data.empty()) {
+        return true;
+    }
+
+    struct context {
+        Buf* buffer;
+        std::size_t offset;
+    } ctx{std::addressof(out), out.size()};
+
+    const auto written = detail::gzip_compress_to(data, level, &ctx, [](void* p, std::size_t bound) -> std::span<std::byte> {
+        auto& [buffer, offset] = *static_cast<context*>(p);
+        buffer->resize(offset + bound);
+        return {reinterpret_cast<std::byte*>(buffer->data()) + offset, bound};
+    });
+
+    try {
+        out.resize(ctx.offset + written.value_or(0));
+    } catch (...) {
+        // 缩小不会分配内存，这里仅为满足 noexcept
+    }
+    return written.has_value();
+}
+
 /**
  * @brief 使用 Gzip 格式压缩数据。
  *
  * @param data 要压缩的原始数据 (string_view 避免拷贝)。
  * @param level 压缩级别 (0-9)，默认为 -1 (Z_DEFAULT_COMPRESSION)。
  * 1 为最快压缩，9 为最佳压缩。
- * @return std::optional<std::string> 成功时返回包含压缩数据的字符串，失败返回 std::nullopt。
+ * @return std::optional<std::string> 成功时返回包含压缩数据的字符串（容量已收缩到实际大小），失败返回 std::nullopt。
  */
 [[nodiscard]]
 std::optional<std::string> gzip_compress(std::string_view data, int level = -1) noexcept;
 
+/**
+ * @brief 在给定上限内解压 Gzip 格式的数据。
+ *
+ * 当 Gzip 尾部的 ISIZE 字段可信时，按其精确预分配输出；否则按需增长，
+ * 且增长永远不会超过上限，一旦超过立即中止。
+ *
+ * @param compressed_data Gzip 格式的压缩数据。
+ * @param limits 输出大小与解压比上限。
+ * @param out 解压结果，失败时内容未定义。
+ * @return inflate_status 成功返回 inflate_status::ok，否则返回具体的失败原因。
+ */
+[[nodiscard]]
+inflate_status gzip_decompress(std::string_view compressed_data, const inflate_limits& limits, std::string& out) noexcept;
+
 /**
  * @brief 解压 Gzip 格式的数据。
  *
+ * 使用默认的 inflate_limits：解压结果超过 64 MiB 或解压比超过 256:1 时返回 std::nullopt。
+ * 早期版本的这个重载不限制输出大小，依赖旧行为解压大文件或高压缩比数据的调用方需要改用带 limits 的重载，
+ * 例如 inflate_limits{.max_output_size = 已知的原始大小, .max_ratio = 0}；需要区分失败原因时同样使用该重载。
+ *
  * @param compressed_data Gzip 格式的压缩数据 (string_view 避免拷贝)。
  * @return std::optional<std::string> 成功时返回解压后的原始字符串，失败返回 std::nullopt。
  */
 [[nodiscard]]
 std::optional<std::string> gzip_decompress(std::string_view compressed_data) noexcept;
+
+/**
+ * @brief 使用预置字典以 zlib (deflate) 格式压缩数据。
+ *
+ * 对于形状固定的小 JSON 响应，预置字典能让首个字节就命中回溯引用；
+ * zlib 头部中的 DICTID 可用于校验双方字典是否一致。
+ *
+ * @param data 要压缩的原始数据。
+ * @param dictionary 预置字典，为空时等同于普通 deflate。
+ * @param level 压缩级别 (0-9)，默认为 -1 (Z_DEFAULT_COMPRESSION)。
+ * @return std::optional<std::string> 成功时返回压缩数据（容量已收缩到实际大小），失败返回 std::nullopt。
+ */
+[[nodiscard]]
+std::optional<std::string> deflate_compress(std::string_view data, std::string_view dictionary, int level = -1) noexcept;
+
+/**
+ * @brief 在给定上限内解压 zlib (deflate) 格式的数据。
+ *
+ * @param compressed_data zlib 格式的压缩数据。
+ * @param dictionary 压缩时使用的预置字典，与流中的 DICTID 不符时返回 inflate_status::invalid_data。
+ * @param limits 输出大小与解压比上限。
+ * @param out 解压结果，失败时内容未定义。
+ * @return inflate_status 成功返回 inflate_status::ok，否则返回具体的失败原因。
+ */
+[[nodiscard]]
+inflate_status deflate_decompress(std::string_view compressed_data, std::string_view dictionary, const inflate_limits& limits, std::string& out) noexcept;
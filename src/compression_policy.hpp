@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+namespace l2q_http{
+struct adaptive_compression_config{
+	int min_level{1};
+	int max_level{9};
+	int initial_level{6};
+
+	// 事件循环延迟 / 活跃请求数 超过 high 视为过载，低于 low 视为空闲，介于两者之间保持不变
+	std::chrono::microseconds lag_high{std::chrono::milliseconds{20}};
+	std::chrono::microseconds lag_low{std::chrono::milliseconds{2}};
+	std::size_t queue_high{64};
+	std::size_t queue_low{8};
+
+	// 滞回：连续多少次采样后才调整一级，降级快、升级慢
+	std::size_t samples_to_decrease{3};
+	std::size_t samples_to_increase{20};
+
+	// 保留的调整历史条数
+	std::size_t history_size{64};
+};
+
+/**
+ * @brief 动态响应压缩级别的自适应策略
+ * 根据事件循环延迟和待处理请求数，在 [min_level, max_level] 之间逐级调整压缩级别：
+ * 高峰时降低级别让出 CPU，空闲时提高级别节省带宽。
+ */
+class adaptive_compression_level{
+public:
+	struct level_change{
+		std::chrono::system_clock::time_point time;
+		int from;
+		int to;
+		std::chrono::microseconds loop_lag;
+		std::size_t queue_depth;
+	};
+
+	explicit adaptive_compression_level(const adaptive_compression_config& config = {}) noexcept
+		: config_(config){
+		config_.min_level = std::clamp(config_.min_level, 0, 9);
+		config_.max_level = std::clamp(config_.max_level, config_.min_level, 9);
+		level_ = std::clamp(config_.initial_level, config_.min_level, config_.max_level);
+	}
+
+	/**
+	 * @brief 当前应使用的压缩级别，可在任意线程调用
+	 */
+	[[nodiscard]] int current() const noexcept{
+		return level_.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief 输入一次负载采样
+	 * @param loop_lag 事件循环延迟（定时器实际唤醒时间与预期的差值）
+	 * @param queue_depth 正在处理的请求数
+	 */
+	void observe(const std::chrono::microseconds loop_lag, const std::size_t queue_depth){
+		std::lock_guard lock{mutex_};
+		last_lag_ = loop_lag;
+		last_queue_depth_ = queue_depth;
+		++samples_;
+
+		const bool overloaded = loop_lag >= config_.lag_high || queue_depth >= config_.queue_high;
+		const bool idle = loop_lag <= config_.lag_low && queue_depth <= config_.queue_low;
+
+		pressure_streak_ = overloaded ? pressure_streak_ + 1 : 0;
+		idle_streak_ = idle ? idle_streak_ + 1 : 0;
+
+		const int level = current();
+		if(pressure_streak_ >= config_.samples_to_decrease && level > config_.min_level){
+			change_level(level, level - 1);
+		} else if(idle_streak_ >= config_.samples_to_increase && level < config_.max_level){
+			change_level(level, level + 1);
+		}
+	}
+
+	/**
+	 * @brief 导出当前级别、最近一次采样以及调整历史
+	 */
+	[[nodiscard]] nlohmann::json metrics() const{
+		std::lock_guard lock{mutex_};
+		nlohmann::json history = nlohmann::json::array();
+		for(const auto& change : history_){
+			history.push_back({
+				{"time_ms", std::chrono::duration_cast<std::chrono::milliseconds>(change.time.time_since_epoch()).count()},
+				{"from", change.from},
+				{"to", change.to},
+				{"loop_lag_us", change.loop_lag.count()},
+				{"queue_depth", change.queue_depth},
+			});
+		}
+
+		return {
+			{"level", current()},
+			{"min_level", config_.min_level},
+			{"max_level", config_.max_level},
+			{"samples", samples_},
+			{"changes", changes_},
+			{"loop_lag_us", last_lag_.count()},
+			{"queue_depth", last_queue_depth_},
+			{"history", std::move(history)},
+		};
+	}
+
+private:
+	void change_level(const int from, const int to){
+		level_.store(to, std::memory_order_relaxed);
+		pressure_streak_ = idle_streak_ = 0;
+		++changes_;
+
+		history_.push_back({std::chrono::system_clock::now(), from, to, last_lag_, last_queue_depth_});
+		while(history_.size() > config_.history_size){
+			history_.pop_front();
+		}
+
+		spdlog::info("compression level {} -> {} (loop lag {}us, queue depth {})",
+			from, to, last_lag_.count(), last_queue_depth_);
+	}
+
+	adaptive_compression_config config_;
+	std::atomic<int> level_{};
+
+	mutable std::mutex mutex_;
+	std::size_t pressure_streak_{};
+	std::size_t idle_streak_{};
+	std::size_t samples_{};
+	std::size_t changes_{};
+	std::chrono::microseconds last_lag_{};
+	std::size_t last_queue_depth_{};
+	std::deque<level_change> history_;
+};
+} // namespace l2q_http
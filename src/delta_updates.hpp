@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include "heterogeneous.hpp"
+#include "package_store.h"
+#include "platform.hpp"
+#include "release_catalog.hpp"
+
+namespace l2q_http{
+/**
+ * @brief 增量更新：为每个频道最近的若干个旧版本预先生成到最新版本的二进制差分
+ * 差分在发布时于后台线程生成（见 release_publisher 的准备步骤），请求线程只查表；
+ * 只记录比完整更新包小的差分，其余情况客户端下载完整更新包。
+ */
+class delta_updates{
+public:
+	/**
+	 * @param history 每个频道为最新版本之前的多少个版本生成差分
+	 */
+	explicit delta_updates(package_store& packages, const std::size_t history = 3) noexcept
+		: packages_(std::addressof(packages)), history_(history){}
+
+	/**
+	 * @brief 为快照中每个频道的最新版本生成差分，已生成的直接复用
+	 * 单个差分失败只记录日志，对应的客户端回退到完整更新包
+	 */
+	void prepare(const catalog_snapshot& snapshot){
+		for(std::size_t a = 0; a < enum_count<os_arch>; ++a){
+			for(std::size_t c = 0; c < enum_count<release_channel>; ++c){
+				const auto& releases = snapshot.track(static_cast<os_arch>(a), static_cast<release_channel>(c)).releases;
+				if(releases.size() < 2 || !releases.back().stored) continue;
+
+				const auto& target = *releases.back().stored;
+				const auto first = releases.size() - 1 - std::min(history_, releases.size() - 1);
+				for(std::size_t i = first; i + 1 < releases.size(); ++i){
+					if(releases[i].stored && releases[i].stored->sha256 != target.sha256){
+						prepare(*releases[i].stored, target);
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief 查找从 base 到 target 的差分，不存在或不比完整更新包小时返回 std::nullopt
+	 */
+	[[nodiscard]] std::optional<delta_info> find(const std::string_view base, const std::string_view target) const{
+		std::lock_guard lock(mutex_);
+		if(const auto* delta = deltas_.try_find(key(base, target))){
+			return *delta;
+		}
+		return std::nullopt;
+	}
+
+	[[nodiscard]] nlohmann::json metrics() const{
+		std::size_t available = 0;
+		{
+			std::lock_guard lock(mutex_);
+			available = deltas_.size();
+		}
+		return {
+			{"available", available},
+			{"generated", generated_.load(std::memory_order_relaxed)},
+			{"not_smaller", not_smaller_.load(std::memory_order_relaxed)},
+			{"failed", failed_.load(std::memory_order_relaxed)},
+		};
+	}
+
+private:
+	void prepare(const package_info& base, const package_info& target){
+		auto delta_key = key(base.sha256, target.sha256);
+		{
+			std::lock_guard lock(mutex_);
+			if(deltas_.contains(delta_key) || skipped_.contains(delta_key)) return;
+		}
+
+		try{
+			auto delta = packages_->delta(base, target);
+			generated_.fetch_add(1, std::memory_order_relaxed);
+
+			std::lock_guard lock(mutex_);
+			if(delta.compressed_size < target.compressed_size){
+				deltas_.insert_or_assign(std::move(delta_key), std::move(delta));
+			} else{
+				not_smaller_.fetch_add(1, std::memory_order_relaxed);
+				skipped_.insert(std::move(delta_key));
+			}
+		} catch(const std::exception& e){
+			failed_.fetch_add(1, std::memory_order_relaxed);
+			spdlog::error("delta sha256:{} -> sha256:{} failed: {}", base.sha256, target.sha256, e.what());
+		}
+	}
+
+	static std::string key(const std::string_view base, const std::string_view target){
+		std::string result;
+		result.reserve(base.size() + 1 + target.size());
+		result.append(base).append(1, '-').append(target);
+		return result;
+	}
+
+	package_store* packages_;
+	std::size_t history_;
+
+	mutable std::mutex mutex_;
+	// base-target -> 可用的差分
+	string_hash_map<delta_info> deltas_;
+	// 不比完整更新包小的差分，不再重复检查
+	string_hash_set<> skipped_;
+
+	std::atomic<std::uint64_t> generated_{0};
+	std::atomic<std::uint64_t> not_smaller_{0};
+	std::atomic<std::uint64_t> failed_{0};
+};
+} // namespace l2q_http
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
 #include <utility>
 #include <unordered_map>
 #include <unordered_set>
@@ -178,4 +183,94 @@ namespace l2q_http{
 			return operator[](std::string_view(key));
 		}
 	};
-}
\ No newline at end of file
+}
+
+namespace l2q_http{
+	/**
+	 * @brief 枚举与字符串之间的映射，特化时提供按枚举值顺序排列的 values
+	 */
+	template <typename E>
+		requires std::is_enum_v<E>
+	struct enum_names;
+}
+
+namespace l2q_http::transparent{
+	/**
+	 * @brief 编译期为 enum_names<E>::values 构造的完美哈希
+	 * 在编译期搜索一个种子，使所有名字经 FNV-1a 哈希后落入互不冲突的槽位，
+	 * 查找时只需一次哈希和一次字符串比较。
+	 */
+	template <typename E>
+	struct perfect_string_hasher{
+		using is_transparent = void;
+
+		static constexpr auto& names = enum_names<E>::values;
+		// 槽位以 std::uint8_t 保存下标 + 1
+		static_assert(names.size() < 256, "perfect_string_hasher supports at most 255 names");
+		static constexpr std::size_t table_size = std::bit_ceil(names.size() * 2);
+
+		static constexpr std::size_t hash(const std::string_view val, const std::uint32_t seed) noexcept{
+			std::uint32_t h = 2166136261u ^ seed;
+			for(const char c : val){
+				h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+			}
+			return (h ^ (h >> 15)) & (table_size - 1);
+		}
+
+		static constexpr std::uint32_t seed = []{
+			for(std::uint32_t candidate = 0;; ++candidate){
+				std::array<bool, table_size> used{};
+				bool collided = false;
+				for(const auto name : names){
+					auto& slot = used[hash(name, candidate)];
+					collided = collided || slot;
+					slot = true;
+				}
+				if(!collided) return candidate;
+			}
+		}();
+
+		// 槽位 -> 枚举下标 + 1，0 表示空槽
+		static constexpr auto table = []{
+			std::array<std::uint8_t, table_size> slots{};
+			for(std::size_t i = 0; i < names.size(); ++i){
+				slots[hash(names[i], seed)] = static_cast<std::uint8_t>(i + 1);
+			}
+			return slots;
+		}();
+
+		constexpr std::size_t operator()(const std::string_view val) const noexcept {
+			return hash(val, seed);
+		}
+
+		std::size_t operator()(const std::string& val) const noexcept {
+			return hash(val, seed);
+		}
+	};
+}
+
+namespace l2q_http{
+	template <typename E>
+	inline constexpr std::size_t enum_count = enum_names<E>::values.size();
+
+	/**
+	 * @brief 字符串 -> 枚举，无法识别时返回 std::nullopt
+	 */
+	template <typename E>
+	constexpr std::optional<E> parse_enum(const std::string_view name) noexcept{
+		using hasher = transparent::perfect_string_hasher<E>;
+		const auto slot = hasher::table[hasher{}(name)];
+		if(slot == 0 || enum_names<E>::values[slot - 1] != name){
+			return std::nullopt;
+		}
+		return static_cast<E>(slot - 1);
+	}
+
+	/**
+	 * @brief 枚举 -> 字符串，返回的 string_view 指向静态存储
+	 */
+	template <typename E>
+	constexpr std::string_view enum_name(const E value) noexcept{
+		return enum_names<E>::values[static_cast<std::size_t>(value)];
+	}
+}
@@ -1,14 +1,37 @@
 #include <asio.hpp>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
-
+#include <spdlog/fmt/chrono.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
 #include <string>
 #include <string_view>
 #include <memory>
 #include <iostream>
 #include <sstream>
 #include <nlohmann/json.hpp>
+#include "byte_range.hpp"
+#include "compress.h"
+#include "compression_policy.hpp"
+#include "posix_file.hpp"
 #include "request_process.hpp"
+#include "response_dictionary.hpp"
 
 // 使用 asio 的命名空间简化代码
 
@@ -31,6 +54,67 @@ namespace l2q_http {
         return http_method::unknown;
     }
 
+    constexpr std::string_view trim(std::string_view str) noexcept {
+        while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) str.remove_prefix(1);
+        while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) str.remove_suffix(1);
+        return str;
+    }
+
+    /**
+     * @brief 解析请求头部分（请求行之后、空行之前），键转换为小写
+     */
+    inline string_hash_map<std::string> parse_headers(std::string_view head) {
+        string_hash_map<std::string> headers;
+
+        // 跳过请求行
+        auto pos = head.find("\r\n");
+        while (pos != std::string_view::npos) {
+            pos += 2;
+            const auto line_end = head.find("\r\n", pos);
+            const auto line = head.substr(pos, line_end == std::string_view::npos ? std::string_view::npos : line_end - pos);
+            pos = line_end;
+
+            const auto colon = line.find(':');
+            if (colon == std::string_view::npos) continue;
+
+            std::string name{trim(line.substr(0, colon))};
+            std::ranges::transform(name, name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            headers.insert_or_assign(std::move(name), std::string{trim(line.substr(colon + 1))});
+        }
+
+        return headers;
+    }
+
+    /**
+     * @brief 判断 Accept-Encoding 是否接受指定的编码（忽略 q=0 的项）
+     */
+    constexpr bool accepts_encoding(std::string_view accept_encoding, std::string_view coding) noexcept {
+        while (!accept_encoding.empty()) {
+            const auto comma = accept_encoding.find(',');
+            auto item = accept_encoding.substr(0, comma);
+            accept_encoding = comma == std::string_view::npos ? std::string_view{} : accept_encoding.substr(comma + 1);
+
+            std::string_view params;
+            if (const auto semi = item.find(';'); semi != std::string_view::npos) {
+                params = trim(item.substr(semi + 1));
+                item = item.substr(0, semi);
+            }
+
+            if (trim(item) == coding) {
+                return params != "q=0" && params != "q=0.0" && params != "q=0.00" && params != "q=0.000";
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 格式化为 HTTP-date，例如 "Sun, 06 Nov 1994 08:49:37 GMT"
+     */
+    inline std::string http_date(const std::filesystem::file_time_type time) {
+        const auto seconds = std::chrono::floor<std::chrono::seconds>(std::chrono::file_clock::to_sys(time));
+        return fmt::format("{:%a, %d %b %Y %H:%M:%S} GMT", fmt::gmtime(std::chrono::system_clock::to_time_t(seconds)));
+    }
+
     /**
      * @brief 简单的 HTTP 会话处理逻辑
      * 注意：为了保持示例简单，这里手动处理了 HTTP 协议字符串。
@@ -39,8 +123,8 @@ namespace l2q_http {
     class http_session {
     public:
         // 移动构造函数，确保 socket 所有权转移
-        explicit http_session(tcp::socket socket, const request_handler& handler) noexcept
-            : socket_(std::move(socket)), handler_(std::addressof(handler)) {}
+        explicit http_session(tcp::socket socket, const request_handler& handler, const adaptive_compression_level* compression = nullptr) noexcept
+            : handler_(std::addressof(handler)), compression_(compression), socket_(std::move(socket)) {}
 
         // 禁止拷贝
         http_session(const http_session&) = delete;
@@ -89,10 +173,29 @@ namespace l2q_http {
                 if (header_end != std::string::npos) {
                     body_str = request_str.substr(header_end + 4);
                 }
+                auto headers = parse_headers(std::string_view{request_str}.substr(0, header_end));
+
+                // 请求体超过第一次读取的部分时按 Content-Length 读完（例如批量查询）；
+                // 超过上限的请求体不读取，直接返回 413，不把截断的内容交给处理者
+                bool body_too_large = false;
+                if (const auto* length_header = headers.try_find("content-length")) {
+                    std::size_t length = 0;
+                    const auto [ptr, ec] = std::from_chars(length_header->data(), length_header->data() + length_header->size(), length);
+                    body_too_large = ec == std::errc::result_out_of_range || (ec == std::errc{} && length > max_body_size);
+                    if (ec == std::errc{} && length > body_str.size() && !body_too_large) {
+                        const auto received = body_str.size();
+                        body_str.resize(length);
+                        co_await asio::async_read(socket_, asio::buffer(body_str.data() + received, length - received), use_awaitable);
+                    }
+                }
 
 
                 request_result result;
-                {
+                if (body_too_large) {
+                    result = request_result{
+                        {{"reason", fmt::format("request body exceeds {} bytes", max_body_size)}}, status_code::payload_too_large
+                    };
+                } else {
                     // 3. 转换为 JSON 并调用 Handler
 
                     try {
@@ -103,7 +206,9 @@ namespace l2q_http {
                         // 调用核心业务逻辑
                         result = handler_->process(path, request_args{
                             .method = string_to_method(method),
-                            .body = std::move(req_json)
+                            .body = std::move(req_json),
+                            .headers = headers,
+                            .remote_address = remote_ep.address()
                         });
                     } catch (const nlohmann::json::parse_error& e) {
                         // JSON 格式错误处理
@@ -113,31 +218,34 @@ namespace l2q_http {
                     }
                 }
 
-                // 4. 序列化响应
-                const auto response_body = result.data.dump();
-                const auto status_str = [](status_code code) -> std::string {
-                    // 简单的状态码转字符串 (TODO 看需不需要使用magic enum)
-                    if (code == status_code::ok) return "200 OK";
-                    if (code == status_code::not_found) return "404 Not Found";
-                    return std::format("{}", static_cast<int>(code)) + " Error";
-                }(result.code);
-
-                const auto response = fmt::format(
-                    "HTTP/1.1 {}\r\n"
-                    "Content-Type: application/json\r\n"
-                    "Content-Length: {}\r\n"
-                    "Connection: close\r\n"
-                    "\r\n"
-                    "{}",
-                    status_str, response_body.size(), response_body
-                );
+                // 长连接推送：连接交给处理者，会话到此结束
+                if (result.upgrade) {
+                    spdlog::debug("connection from {} handed off", remote_ep.address().to_string());
+                    result.upgrade(std::move(socket_));
+                    co_return;
+                }
 
-                // 3. 发送响应
-                co_await asio::async_write(
-                    socket_, 
-                    asio::buffer(response), 
-                    use_awaitable
-                );
+                // 条件请求在生成任何响应体之前判断。处理者确认验证器匹配后返回 not_modified，不做生成响应体的工作；
+                // 304 带有与 200 相同的验证器：JSON 响应按同样的协商规则决定是否为弱标签
+                const auto* if_none_match = headers.try_find("if-none-match");
+                if (!result.raw && (result.code == status_code::not_modified
+                                    || (result.code == status_code::ok && if_none_match && etag_matches(*if_none_match, result.etag)))) {
+                    const bool negotiated = compression_ && result.file.empty() && !result.stream;
+                    const auto etag = negotiated && negotiate(headers).weak() ? "W/" + result.etag : result.etag;
+                    result.raw = l2q_http::make_response_bytes(serialize_not_modified(etag, result.cache_control, negotiated ? negotiated_vary : std::string_view{}));
+                } else if (result.deferred) {
+                    result.raw = co_await result.deferred();
+                }
+
+                if (result.raw) {
+                    co_await asio::async_write(socket_, asio::buffer(*result.raw), use_awaitable);
+                } else if (!result.file.empty()) {
+                    co_await write_file(result, headers);
+                } else if (result.stream) {
+                    co_await write_stream(result);
+                } else {
+                    co_await write_json(result, headers);
+                }
 
                 spdlog::debug("response sent to {}", remote_ep.address().to_string());
 
@@ -151,7 +259,300 @@ namespace l2q_http {
         }
 
     private:
+        /**
+         * @brief 序列化 JSON 响应并发送
+         */
+        awaitable<void> write_json(const request_result& result, const string_hash_map<std::string>& headers) {
+            auto response_body = result.body.empty() ? result.data.dump() : result.body;
+
+            // 动态响应按自适应策略给出的级别压缩
+            std::string encoding_headers;
+            const auto encoding = negotiate(headers);
+            if (compression_) {
+                // 显式声明持有字典的内部客户端：小响应也用预置字典 deflate 压缩
+                if (encoding.dictionary) {
+                    if (auto compressed = deflate_compress(response_body, encoding.dictionary->data, compression_->current())) {
+                        response_body = std::move(*compressed);
+                        encoding_headers = fmt::format("Content-Encoding: deflate\r\n{}: {}\r\n", dictionary_header, encoding.dictionary->id);
+                    }
+                } else if (encoding.gzip && response_body.size() >= min_compress_size) {
+                    if (auto compressed = gzip_compress(response_body, compression_->current())) {
+                        response_body = std::move(*compressed);
+                        encoding_headers = "Content-Encoding: gzip\r\n";
+                    }
+                }
+
+                fmt::format_to(std::back_inserter(encoding_headers), "Vary: {}\r\n", negotiated_vary);
+            }
+
+            const auto response = serialize_response(result.code, result.content_type, extra_headers(result, encoding.weak()) + encoding_headers, response_body);
+
+            // 发送响应
+            co_await asio::async_write(
+                socket_, 
+                asio::buffer(response), 
+                use_awaitable
+            );
+        }
+
+        /**
+         * @brief 以 chunked 传输编码发送流式响应体，每段数据直接作为分散写入的缓冲区，不做拼接
+         * 流在中途失败时状态行已经发出，只能不发送结束块直接断开，由客户端识别为截断
+         */
+        awaitable<void> write_stream(const request_result& result) {
+            const auto head = fmt::format(
+                "HTTP/1.1 {}\r\n"
+                "Content-Type: {}\r\n"
+                "{}"
+                "Transfer-Encoding: chunked\r\n"
+                "Connection: close\r\n"
+                "\r\n",
+                status_line(result.code), result.content_type, extra_headers(result)
+            );
+            co_await asio::async_write(socket_, asio::buffer(head), use_awaitable);
+
+            char chunk_head[20];
+            while (true) {
+                const auto chunk = result.stream();
+                if (chunk.empty()) break;
+
+                const auto head_end = fmt::format_to(chunk_head, "{:x}\r\n", chunk.size());
+                const std::array<asio::const_buffer, 3> buffers{
+                    asio::buffer(chunk_head, static_cast<std::size_t>(head_end - chunk_head)),
+                    asio::buffer(chunk),
+                    asio::buffer("\r\n", 2),
+                };
+                co_await asio::async_write(socket_, buffers, use_awaitable);
+            }
+
+            co_await asio::async_write(socket_, asio::buffer("0\r\n\r\n", 5), use_awaitable);
+        }
+
+        /**
+         * @brief 发送文件响应体，支持 Range / If-Range（单个范围与 multipart/byteranges）
+         * 响应头作为普通缓冲区先行写出；文件内容在 Linux 上通过 sendfile 由内核直接从页缓存写入 socket，
+         * 不经过用户空间。sendfile 不可用时（例如文件所在的文件系统不支持）退回到 mmap 映射后写出，
+         * 仍然省去读入用户缓冲区的拷贝。部分响应与完整响应走同一条路径
+         */
+        awaitable<void> write_file(const request_result& result, const string_hash_map<std::string>& headers) {
+#if defined(__unix__) || defined(__APPLE__)
+            const readonly_file file(result.file);
+            const auto size = file.size();
+            std::optional<mapped_region> mapping;
+            const auto write_range = [&](std::uint64_t offset, std::uint64_t length) {
+                return write_file_range(file, mapping, offset, length);
+            };
+#else
+            std::ifstream file(result.file, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error(fmt::format("failed to open {}", result.file.string()));
+            }
+            const auto size = std::filesystem::file_size(result.file);
+            const auto write_range = [&](std::uint64_t offset, std::uint64_t length) {
+                return write_file_range(file, offset, length);
+            };
+#endif
+            const auto last_modified = http_date(std::filesystem::last_write_time(result.file));
+            const auto common_headers = fmt::format("{}Accept-Ranges: bytes\r\nLast-Modified: {}\r\n", extra_headers(result), last_modified);
+
+            const auto ranges = result.code == status_code::ok ? requested_ranges(result, headers, size, last_modified) : std::nullopt;
+            if (!ranges) {
+                const auto head = serialize_response_head(result.code, result.content_type, common_headers, size);
+                co_await asio::async_write(socket_, asio::buffer(head), use_awaitable);
+                co_await write_range(0, size);
+                co_return;
+            }
+
+            if (ranges->empty()) {
+                const auto head = serialize_response_head(status_code::range_not_satisfiable, result.content_type,
+                    fmt::format("{}Content-Range: bytes */{}\r\n", common_headers, size), 0);
+                co_await asio::async_write(socket_, asio::buffer(head), use_awaitable);
+                co_return;
+            }
+
+            if (ranges->size() == 1) {
+                const auto range = ranges->front();
+                const auto head = serialize_response_head(status_code::partial_content, result.content_type,
+                    fmt::format("{}Content-Range: bytes {}-{}/{}\r\n", common_headers, range.first, range.last, size), range.length());
+                co_await asio::async_write(socket_, asio::buffer(head), use_awaitable);
+                co_await write_range(range.first, range.length());
+                co_return;
+            }
+
+            // multipart/byteranges：先算出每个分段的头部，以便给出精确的 Content-Length
+            const auto boundary = fmt::format("l2q-{:016x}", std::mt19937_64{std::random_device{}()}());
+            std::vector<std::string> part_heads;
+            part_heads.reserve(ranges->size());
+            std::uint64_t content_length = 0;
+            for (const auto& range : *ranges) {
+                part_heads.push_back(fmt::format(
+                    "{}--{}\r\n"
+                    "Content-Type: {}\r\n"
+                    "Content-Range: bytes {}-{}/{}\r\n"
+                    "\r\n",
+                    part_heads.empty() ? "" : "\r\n", boundary, result.content_type, range.first, range.last, size));
+                content_length += part_heads.back().size() + range.length();
+            }
+            const auto closing = fmt::format("\r\n--{}--\r\n", boundary);
+            content_length += closing.size();
+
+            const auto head = serialize_response_head(status_code::partial_content, fmt::format("multipart/byteranges; boundary={}", boundary), common_headers, content_length);
+            co_await asio::async_write(socket_, asio::buffer(head), use_awaitable);
+            for (std::size_t i = 0; i < ranges->size(); ++i) {
+                co_await asio::async_write(socket_, asio::buffer(part_heads[i]), use_awaitable);
+                co_await write_range((*ranges)[i].first, (*ranges)[i].length());
+            }
+            co_await asio::async_write(socket_, asio::buffer(closing), use_awaitable);
+        }
+
+        /**
+         * @brief 取得本次响应要发送的范围
+         * 没有 Range、Range 无效或 If-Range 与当前内容不符时返回 std::nullopt，发送完整内容。
+         * If-Range 可以是强 ETag（与 request_result::etag 比较）或 Last-Modified 时间（精确比较）
+         */
+        static std::optional<std::vector<byte_range>> requested_ranges(const request_result& result, const string_hash_map<std::string>& headers,
+                                                                       std::uint64_t size, std::string_view last_modified) {
+            const auto* range = headers.try_find("range");
+            if (!range) {
+                return std::nullopt;
+            }
+
+            if (const auto* if_range = headers.try_find("if-range")) {
+                // If-Range 要求强比较，弱标签永不匹配
+                if (*if_range != last_modified && (result.etag.empty() || *if_range != result.etag)) {
+                    return std::nullopt;
+                }
+            }
+
+            return parse_byte_ranges(*range, size);
+        }
+
+#if defined(__unix__) || defined(__APPLE__)
+        /**
+         * @brief 发送文件中的一段，优先 sendfile，不可用时改用（并保留）内存映射
+         */
+        awaitable<void> write_file_range(const readonly_file& file, std::optional<mapped_region>& mapping, std::uint64_t offset, std::uint64_t length) {
+#if defined(__linux__)
+            if (!mapping) {
+                const bool sent = co_await send_file(file, offset, length);
+                if (sent) {
+                    co_return;
+                }
+            }
+#endif
+            if (!mapping) {
+                mapping.emplace(file);
+            }
+            co_await asio::async_write(socket_, asio::buffer(static_cast<const char*>(mapping->data()) + offset, length), use_awaitable);
+        }
+#else
+        awaitable<void> write_file_range(std::ifstream& file, std::uint64_t offset, std::uint64_t length) {
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(offset));
+
+            std::vector<char> chunk(64 * 1024);
+            while (length != 0 && file) {
+                file.read(chunk.data(), static_cast<std::streamsize>(std::min<std::uint64_t>(chunk.size(), length)));
+                const auto count = static_cast<std::size_t>(file.gcount());
+                if (count == 0) {
+                    break;
+                }
+                co_await asio::async_write(socket_, asio::buffer(chunk.data(), count), use_awaitable);
+                length -= count;
+            }
+            if (length != 0) {
+                throw std::runtime_error("file truncated while sending");
+            }
+        }
+#endif
+
+#if defined(__linux__)
+        /**
+         * @brief 用 sendfile 发送文件中的一段，socket 发送缓冲区满时挂起等待可写
+         * @return 发送完成返回 true；尚未发送任何数据时发现 sendfile 不支持该文件则返回 false
+         */
+        awaitable<bool> send_file(const readonly_file& file, std::uint64_t first, std::uint64_t length) {
+            socket_.native_non_blocking(true);
+
+            auto offset = static_cast<off_t>(first);
+            const auto end = static_cast<off_t>(first + length);
+            while (offset < end) {
+                const auto sent = ::sendfile(socket_.native_handle(), file.native_handle(), &offset, static_cast<std::size_t>(end - offset));
+                if (sent > 0) {
+                    continue;
+                }
+                if (sent == 0) {
+                    throw std::runtime_error("file truncated while sending");
+                }
+
+                switch (errno) {
+                    case EINTR:
+                        break;
+                    case EAGAIN:
+                        co_await socket_.async_wait(tcp::socket::wait_write, use_awaitable);
+                        break;
+                    case EINVAL:
+                    case ENOSYS:
+                        if (offset == static_cast<off_t>(first)) {
+                            co_return false;
+                        }
+                        [[fallthrough]];
+                    default:
+                        throw std::system_error(errno, std::generic_category(), "sendfile");
+                }
+            }
+            co_return true;
+        }
+#endif
+
+        /**
+         * @brief JSON 响应的编码协商结果，只由请求头决定
+         */
+        struct json_encoding {
+            const compression_dictionary* dictionary{};
+            bool gzip{};
+
+            // 压缩后的字节与原始表示不同，实体标签降为弱标签。是否真正压缩还取决于响应体大小，
+            // 而 304 在不生成响应体的情况下也要给出与 200 相同的验证器，所以只要可能压缩就使用弱标签
+            [[nodiscard]] bool weak() const noexcept {
+                return dictionary || gzip;
+            }
+        };
+
+        [[nodiscard]] json_encoding negotiate(const string_hash_map<std::string>& headers) const {
+            const auto* accept = headers.try_find("accept-encoding");
+            if (!compression_ || !accept) {
+                return {};
+            }
+            const auto* wanted_dictionary = headers.try_find("x-l2q-dictionary");
+            if (const auto* dictionary = wanted_dictionary ? find_dictionary(*wanted_dictionary) : nullptr;
+                dictionary && accepts_encoding(*accept, "deflate")) {
+                return {.dictionary = dictionary};
+            }
+            return {.gzip = accepts_encoding(*accept, "gzip")};
+        }
+
+        static std::string extra_headers(const request_result& result, bool weak_etag = false) {
+            std::string lines;
+            for (const auto& [name, value] : result.headers) {
+                fmt::format_to(std::back_inserter(lines), "{}: {}\r\n", name, value);
+            }
+            if (!result.etag.empty()) {
+                fmt::format_to(std::back_inserter(lines), "ETag: {}{}\r\n", weak_etag ? "W/" : "", result.etag);
+            }
+            if (!result.cache_control.empty()) {
+                fmt::format_to(std::back_inserter(lines), "Cache-Control: {}\r\n", result.cache_control);
+            }
+            return lines;
+        }
+
+        // 小于该大小的响应不值得压缩
+        static constexpr std::size_t min_compress_size = 1024;
+        // 请求体（Content-Length）的上限，超过时返回 413
+        static constexpr std::size_t max_body_size = 1024 * 1024;
+
         const request_handler* handler_;
+        const adaptive_compression_level* compression_;
         tcp::socket socket_;
     };
 
@@ -168,8 +569,26 @@ namespace l2q_http {
          * @brief 启动监听协程
          */
         void start() {
+#if defined(__unix__) || defined(__APPLE__)
+            // sendfile 直接写 socket，不像 asio 自身的发送那样带 MSG_NOSIGNAL，对端提前断开时会触发 SIGPIPE
+            std::signal(SIGPIPE, SIG_IGN);
+#endif
             // 将监听协程放入 io_context 执行
             co_spawn(io_context_, listener(), detached);
+
+            if (compression_) {
+                co_spawn(io_context_, load_monitor(), detached);
+            }
+        }
+
+        /**
+         * @brief 启用动态响应压缩
+         * @param policy 自适应压缩级别策略，生命周期需长于 server
+         * @param sample_interval 负载采样间隔
+         */
+        void enable_compression(adaptive_compression_level& policy, std::chrono::milliseconds sample_interval = std::chrono::milliseconds{100}) noexcept {
+            compression_ = std::addressof(policy);
+            sample_interval_ = sample_interval;
         }
 
         template <typename Fn>
@@ -198,15 +617,17 @@ namespace l2q_http {
                     
                     // 为每个新连接生成一个新的协程进行处理
                     // 使用 std::move 将 socket 所有权转移给 session
-                    auto session = http_session(std::move(socket), handler_);
+                    auto session = http_session(std::move(socket), handler_, compression_);
                     
                     // 使用 co_spawn 启动会话协程，并将其与当前上下文分离(detached)
                     // 注意：这里需要将 session 移动进 lambda 或者由 session 类自行管理生命周期
                     // 简单的做法是利用 C++20 协程传值保存临时对象，或者使用 shared_ptr
+                    active_sessions_.fetch_add(1, std::memory_order_relaxed);
                     co_spawn(
                         executor,
-                        [sess = std::move(session)]() mutable -> awaitable<void> {
+                        [this, sess = std::move(session)]() mutable -> awaitable<void> {
                             co_await sess.process();
+                            active_sessions_.fetch_sub(1, std::memory_order_relaxed);
                         },
                         detached
                     );
@@ -216,9 +637,29 @@ namespace l2q_http {
             }
         }
 
+        /**
+         * @brief 周期性采样事件循环延迟与活跃会话数，驱动自适应压缩策略
+         */
+        awaitable<void> load_monitor() {
+            asio::steady_timer timer(co_await asio::this_coro::executor);
+
+            while (true) {
+                const auto expected = std::chrono::steady_clock::now() + sample_interval_;
+                timer.expires_at(expected);
+                co_await timer.async_wait(use_awaitable);
+
+                const auto lag = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - expected);
+                compression_->observe(std::max(lag, std::chrono::microseconds::zero()), active_sessions_.load(std::memory_order_relaxed));
+            }
+        }
+
         request_handler handler_{};
         asio::io_context& io_context_;
         std::uint16_t port_;
+
+        adaptive_compression_level* compression_{};
+        std::chrono::milliseconds sample_interval_{100};
+        std::atomic<std::size_t> active_sessions_{};
     };
 
 } // namespace simple_web
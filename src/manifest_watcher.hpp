@@ -0,0 +1,246 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <asio.hpp>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include "release_catalog.hpp"
+#include "release_publisher.hpp"
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace l2q_http{
+/**
+ * @brief 监视清单文件与更新包所在目录（inotify），变化后自动重新加载发布目录
+ * 一连串的事件在最后一个事件之后静默 debounce 时间才触发一次重新加载；加载由 release_publisher::reload
+ * 在后台执行器上完成（解析、校验、入库与准备），失败时保留当前快照，下一次变化时再试。
+ * 监视的目录在每次加载后按新快照中的更新包路径更新。只支持 Linux，其他平台上 start 只记录日志。
+ */
+class manifest_watcher{
+public:
+	/**
+	 * @param executor 读取 inotify 事件与计时的执行器（事件循环）
+	 * @param debounce 最后一个事件之后等待的时间
+	 */
+	manifest_watcher(const asio::any_io_executor& executor, release_publisher& publisher, const release_catalog& catalog,
+	                 std::filesystem::path manifest, const std::chrono::steady_clock::duration debounce)
+		: executor_(executor), publisher_(std::addressof(publisher)), catalog_(std::addressof(catalog)),
+		  manifest_(std::filesystem::absolute(manifest).lexically_normal()), debounce_(debounce), timer_(executor){}
+
+	manifest_watcher(const manifest_watcher&) = delete;
+	manifest_watcher& operator=(const manifest_watcher&) = delete;
+
+	~manifest_watcher(){
+#if defined(__linux__)
+		if(stream_ && stream_->is_open()){
+			std::error_code ec;
+			stream_->close(ec);
+		}
+#endif
+	}
+
+	/**
+	 * @brief 开始监视
+	 * @throw std::system_error 无法创建 inotify 实例
+	 */
+	void start(){
+#if defined(__linux__)
+		const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(fd < 0){
+			throw std::system_error(errno, std::generic_category(), "inotify_init1");
+		}
+		stream_.emplace(executor_, fd);
+		update_watches();
+
+		timer_.expires_at(std::chrono::steady_clock::time_point::max());
+		auto reader = [this]() -> asio::awaitable<void>{
+			co_await read_events();
+		};
+		auto debouncer = [this]() -> asio::awaitable<void>{
+			co_await reload_after_quiet();
+		};
+		asio::co_spawn(executor_, std::move(reader), asio::detached);
+		asio::co_spawn(executor_, std::move(debouncer), asio::detached);
+		spdlog::info("watching {} for changes", manifest_.string());
+#else
+		spdlog::warn("manifest hot reload is not supported on this platform");
+#endif
+	}
+
+	[[nodiscard]] nlohmann::json metrics() const{
+		std::string last_error;
+		{
+			std::lock_guard lock(error_mutex_);
+			last_error = last_error_;
+		}
+		return {
+			{"reloads", reloads_.load(std::memory_order_relaxed)},
+			{"unchanged", unchanged_.load(std::memory_order_relaxed)},
+			{"failures", failures_.load(std::memory_order_relaxed)},
+			{"last_latency_ms", last_latency_ms_.load(std::memory_order_relaxed)},
+			{"last_error", std::move(last_error)},
+		};
+	}
+
+private:
+#if defined(__linux__)
+	asio::awaitable<void> read_events(){
+		alignas(inotify_event) std::array<char, 16 * 1024> buffer;
+		while(true){
+			std::error_code ec;
+			const auto n = co_await stream_->async_read_some(asio::buffer(buffer), asio::redirect_error(asio::use_awaitable, ec));
+			if(ec == asio::error::operation_aborted){
+				co_return;
+			}
+			if(ec){
+				spdlog::error("inotify read failed: {}", ec.message());
+				co_return;
+			}
+
+			bool relevant = false;
+			for(std::size_t offset = 0; offset + sizeof(inotify_event) <= n;){
+				const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+				relevant = relevant || is_relevant(*event);
+				offset += sizeof(inotify_event) + event->len;
+			}
+			if(!relevant){
+				continue;
+			}
+
+			// 每个事件都把计时器推迟到 debounce 之后，一连串写入只触发一次加载
+			if(!pending_){
+				pending_ = true;
+				first_event_ = std::chrono::steady_clock::now();
+			}
+			timer_.expires_after(debounce_);
+		}
+	}
+
+	asio::awaitable<void> reload_after_quiet(){
+		while(true){
+			std::error_code ec;
+			co_await timer_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+			if(ec == asio::error::operation_aborted && stream_ && stream_->is_open()){
+				// 计时器被新的事件推迟，继续等待
+				continue;
+			}
+			if(ec || !pending_){
+				co_return;
+			}
+
+			pending_ = false;
+			timer_.expires_at(std::chrono::steady_clock::time_point::max());
+			const auto started = first_event_;
+			try{
+				const bool published = co_await publisher_->reload();
+				const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+				last_latency_ms_.store(static_cast<std::uint64_t>(latency.count()), std::memory_order_relaxed);
+				if(published){
+					reloads_.fetch_add(1, std::memory_order_relaxed);
+					spdlog::info("manifest reloaded {}ms after the first change", latency.count());
+				} else{
+					unchanged_.fetch_add(1, std::memory_order_relaxed);
+					spdlog::debug("manifest reload skipped, content unchanged");
+				}
+			} catch(const std::exception& e){
+				failures_.fetch_add(1, std::memory_order_relaxed);
+				{
+					std::lock_guard lock(error_mutex_);
+					last_error_ = e.what();
+				}
+				spdlog::error("manifest reload failed, keeping generation {}: {}", catalog_->snapshot()->generation(), e.what());
+			}
+			update_watches();
+		}
+	}
+
+	bool is_relevant(const inotify_event& event) const{
+		if(event.mask & IN_Q_OVERFLOW){
+			return true;
+		}
+		const std::string_view name = event.len ? std::string_view{event.name} : std::string_view{};
+		// 临时文件（清单与入库过程中写入）在重命名时才有意义
+		if(name.ends_with(".tmp")){
+			return false;
+		}
+
+		const auto it = watches_.find(event.wd);
+		if(it == watches_.end()){
+			return false;
+		}
+		if(it->second == manifest_.parent_path()){
+			// 清单目录下由服务自己维护的子目录
+			return name != "store" && name != "incoming";
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 监视清单所在目录（清单通常以重命名的方式替换）与当前快照中所有更新包所在的目录
+	 */
+	void update_watches(){
+		std::unordered_set<std::string> wanted;
+		wanted.insert(manifest_.parent_path().string());
+		for(const auto& package : catalog_->snapshot()->package_paths()){
+			wanted.insert(std::filesystem::absolute(package).lexically_normal().parent_path().string());
+		}
+
+		for(auto it = watches_.begin(); it != watches_.end();){
+			if(wanted.erase(it->second.string())){
+				++it;
+			} else{
+				inotify_rm_watch(stream_->native_handle(), it->first);
+				it = watches_.erase(it);
+			}
+		}
+
+		constexpr std::uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF;
+		for(const auto& directory : wanted){
+			const int wd = inotify_add_watch(stream_->native_handle(), directory.c_str(), mask);
+			if(wd < 0){
+				spdlog::warn("cannot watch {}: {}", directory, std::generic_category().message(errno));
+				continue;
+			}
+			watches_.insert_or_assign(wd, std::filesystem::path{directory});
+		}
+	}
+
+	std::optional<asio::posix::stream_descriptor> stream_;
+	// inotify 监视描述符 -> 目录
+	std::unordered_map<int, std::filesystem::path> watches_;
+#endif
+
+	asio::any_io_executor executor_;
+	release_publisher* publisher_;
+	const release_catalog* catalog_;
+	std::filesystem::path manifest_;
+	std::chrono::steady_clock::duration debounce_;
+
+	// 只在事件循环上访问
+	asio::steady_timer timer_;
+	bool pending_{false};
+	std::chrono::steady_clock::time_point first_event_{};
+
+	std::atomic<std::uint64_t> reloads_{0};
+	std::atomic<std::uint64_t> unchanged_{0};
+	std::atomic<std::uint64_t> failures_{0};
+	std::atomic<std::uint64_t> last_latency_ms_{0};
+	mutable std::mutex error_mutex_;
+	std::string last_error_;
+};
+} // namespace l2q_http
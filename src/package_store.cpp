@@ -0,0 +1,231 @@
+#include "package_store.h"
+
+#include "atomic_file.hpp"
+#include "binary_delta.h"
+#include "compress.h"
+#include "sha256.h"
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+
+namespace l2q_http {
+    namespace {
+        constexpr std::size_t chunk_size = 64 * 1024;
+
+        std::int64_t mtime_of(const std::filesystem::path& path) {
+            return static_cast<std::int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+        }
+
+        struct deflate_guard {
+            z_stream zs{};
+
+            deflate_guard() {
+                // 15 + 16 启用 Gzip 头部处理，与 gzip_compress 输出格式一致
+                if (deflateInit2(&zs, 9, Z_DEFLATED, 15 | 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                    throw std::runtime_error("failed to initialize deflate stream");
+                }
+            }
+
+            ~deflate_guard() {
+                deflateEnd(&zs);
+            }
+        };
+    }
+
+    package_store::package_store(std::filesystem::path root) : root_(std::move(root)) {
+        std::filesystem::create_directories(root_ / "objects");
+    }
+
+    package_info package_store::ingest(const std::filesystem::path& source) {
+        const auto key = std::filesystem::absolute(source).lexically_normal().string();
+        const auto size = std::filesystem::file_size(source);
+        const auto mtime = mtime_of(source);
+
+        {
+            std::lock_guard lock(mutex_);
+            // 从发布目录镜像启动时不需要索引，第一次入库时才读取
+            if (!index_loaded_) {
+                load_index();
+                index_loaded_ = true;
+            }
+            if (const auto it = index_.find(key); it != index_.end()) {
+                const auto& [indexed_mtime, info] = it->second;
+                if (indexed_mtime == mtime && info.size == size && std::filesystem::exists(info.object)) {
+                    return info;
+                }
+            }
+        }
+
+        // 读取与压缩不持锁，不同的更新包可以并行入库
+        auto info = store(source);
+
+        std::lock_guard lock(mutex_);
+        index_.insert_or_assign(key, index_entry{mtime, info});
+        save_index();
+        return info;
+    }
+
+    package_info package_store::store(const std::filesystem::path& source) {
+        std::ifstream in(source, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("failed to open package " + source.string());
+        }
+
+        // 摘要在读完之后才知道，先写入唯一的临时文件；并发入库相同内容时互不覆盖，失败时临时文件被删除
+        temp_file temp(root_ / "objects" / "ingest");
+        std::ofstream out(temp.path(), std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("failed to create " + temp.path().string());
+        }
+
+        sha256 hasher;
+        deflate_guard deflater;
+        auto& zs = deflater.zs;
+        std::vector<char> input(chunk_size);
+        std::vector<char> output(chunk_size);
+        std::uint64_t size = 0;
+        std::uint64_t compressed_size = 0;
+
+        // 每块数据读入后同时送入哈希与压缩器，源文件只读取一次
+        int ret = Z_OK;
+        while (ret != Z_STREAM_END) {
+            in.read(input.data(), static_cast<std::streamsize>(input.size()));
+            if (in.bad()) {
+                throw std::runtime_error("failed to read package " + source.string());
+            }
+            const auto count = static_cast<std::size_t>(in.gcount());
+            hasher.update(std::string_view{input.data(), count});
+            size += count;
+
+            zs.next_in = reinterpret_cast<const Bytef*>(input.data());
+            zs.avail_in = static_cast<uInt>(count);
+            const int flush = in ? Z_NO_FLUSH : Z_FINISH;
+            do {
+                zs.next_out = reinterpret_cast<Bytef*>(output.data());
+                zs.avail_out = static_cast<uInt>(output.size());
+                ret = deflate(&zs, flush);
+                if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                    throw std::runtime_error("deflate failed");
+                }
+                const auto produced = output.size() - zs.avail_out;
+                out.write(output.data(), static_cast<std::streamsize>(produced));
+                compressed_size += produced;
+            } while (zs.avail_out == 0);
+        }
+
+        out.close();
+        if (!out) {
+            throw std::runtime_error("failed to write " + temp.path().string());
+        }
+
+        auto digest = sha256::to_hex(hasher.finish());
+        auto directory = root_ / "objects" / digest.substr(0, 2);
+        std::filesystem::create_directories(directory);
+        auto object = directory / (digest + ".gz");
+
+        // 相同内容的对象已经存在时丢弃本次结果（临时文件随 temp 删除）；否则重命名，读取方不会看到写了一半的对象
+        if (std::filesystem::exists(object)) {
+            spdlog::info("package {} deduplicated as sha256:{}", source.string(), digest);
+        } else {
+            temp.commit(object);
+            spdlog::info("package {} stored as sha256:{} ({} -> {} bytes)", source.string(), digest, size, compressed_size);
+        }
+
+        return package_info{std::move(digest), size, compressed_size, std::move(object)};
+    }
+
+    std::string package_store::read(const package_info& package) const {
+        std::ifstream in(package.object, std::ios::binary);
+        std::string compressed(package.compressed_size, '\0');
+        in.read(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+        if (!in) {
+            throw std::runtime_error("failed to read package object " + package.object.string());
+        }
+
+        std::string data;
+        const auto status = gzip_decompress(compressed, inflate_limits{.max_output_size = package.size, .max_ratio = 0}, data);
+        if (status != inflate_status::ok || data.size() != package.size) {
+            throw std::runtime_error(fmt::format("failed to decompress package object {}: {}", package.object.string(), to_string(status)));
+        }
+        return data;
+    }
+
+    delta_info package_store::delta(const package_info& base, const package_info& target) {
+        auto directory = root_ / "deltas" / base.sha256.substr(0, 2);
+        auto object = directory / fmt::format("{}-{}.gz", base.sha256, target.sha256);
+
+        // 差分由两端的内容唯一确定，已经生成过的直接复用
+        if (std::error_code ec; std::filesystem::is_regular_file(object, ec)) {
+            return delta_info{base.sha256, target.sha256, std::filesystem::file_size(object), std::move(object)};
+        }
+
+        const auto base_data = read(base);
+        const auto target_data = read(target);
+        const auto patch = make_delta(base_data, target_data);
+
+        // 发布前先确认差分能还原出目标，客户端不会收到错误的差分
+        const auto rebuilt = apply_delta(base_data, patch);
+        if (!rebuilt || sha256::to_hex(sha256::hash(*rebuilt)) != target.sha256) {
+            throw std::runtime_error(fmt::format("delta sha256:{} -> sha256:{} failed verification", base.sha256, target.sha256));
+        }
+
+        auto compressed = gzip_compress(patch, 9);
+        if (!compressed) {
+            throw std::runtime_error("failed to compress delta");
+        }
+
+        std::filesystem::create_directories(directory);
+        write_file_atomic(object, *compressed);
+        spdlog::info("delta sha256:{} -> sha256:{} stored ({} bytes, full package {} bytes)",
+            base.sha256, target.sha256, compressed->size(), target.compressed_size);
+
+        return delta_info{base.sha256, target.sha256, compressed->size(), std::move(object)};
+    }
+
+    void package_store::load_index() {
+        std::ifstream file(root_ / "index.json");
+        if (!file) {
+            return;
+        }
+
+        try {
+            const auto index = nlohmann::json::parse(file);
+            for (const auto& [source, entry] : index.at("packages").items()) {
+                const auto digest = entry.at("sha256").get<std::string>();
+                if (digest.size() != 64) {
+                    continue;
+                }
+                index_.emplace(source, index_entry{
+                    entry.at("mtime").get<std::int64_t>(),
+                    package_info{
+                        digest,
+                        entry.at("size").get<std::uint64_t>(),
+                        entry.at("compressed_size").get<std::uint64_t>(),
+                        root_ / "objects" / digest.substr(0, 2) / (digest + ".gz"),
+                    },
+                });
+            }
+        } catch (const std::exception& e) {
+            // 索引只是缓存，损坏时丢弃，之后会重新计算
+            spdlog::warn("ignoring corrupt package index: {}", e.what());
+            index_.clear();
+        }
+    }
+
+    void package_store::save_index() const {
+        nlohmann::json packages = nlohmann::json::object();
+        for (const auto& [source, entry] : index_) {
+            packages[source] = {
+                {"mtime", entry.mtime},
+                {"sha256", entry.info.sha256},
+                {"size", entry.info.size},
+                {"compressed_size", entry.info.compressed_size},
+            };
+        }
+
+        write_file_atomic(root_ / "index.json", nlohmann::json{{"packages", std::move(packages)}}.dump(2));
+    }
+}
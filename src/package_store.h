@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace l2q_http {
+    /**
+     * @brief 存储中的一个更新包对象。
+     */
+    struct package_info {
+        /// 原始数据 SHA-256 的小写十六进制
+        std::string sha256;
+        std::uint64_t size{};
+        std::uint64_t compressed_size{};
+        /// Gzip 压缩后的对象文件
+        std::filesystem::path object;
+
+        /**
+         * @brief 对外公布的校验码，格式为 算法:十六进制摘要
+         */
+        [[nodiscard]] std::string hash() const {
+            return "sha256:" + sha256;
+        }
+    };
+
+    /**
+     * @brief 存储中两个更新包之间的二进制差分对象（格式见 binary_delta.h），以 Gzip 压缩保存。
+     */
+    struct delta_info {
+        /// 差分基准与目标的原始数据 SHA-256
+        std::string base;
+        std::string target;
+        std::uint64_t compressed_size{};
+        std::filesystem::path object;
+    };
+
+    /**
+     * @brief 按内容寻址的更新包存储。
+     *
+     * 入库时一次读取同时完成 SHA-256 计算与 Gzip 压缩，对象以摘要命名保存在
+     * root/objects/xx/<sha256>.gz；内容相同的更新包（例如同时发布到多个通道或架构）
+     * 只保存一份。root/index.json 记录 源文件路径 + 修改时间 + 大小 到摘要的映射，
+     * 未变化的源文件在重启或重新加载清单时不会再次读取。
+     *
+     * 可被多个线程同时调用。
+     */
+    class package_store {
+    public:
+        /**
+         * @throw std::filesystem::filesystem_error 无法创建存储目录
+         */
+        explicit package_store(std::filesystem::path root);
+
+        /**
+         * @brief 将源文件入库，已入库且未变化时直接返回记录
+         * @throw std::runtime_error 读取、压缩或写入失败
+         */
+        package_info ingest(const std::filesystem::path& source);
+
+        /**
+         * @brief 读取对象并解压为原始数据
+         * @throw std::runtime_error 读取或解压失败
+         */
+        [[nodiscard]] std::string read(const package_info& package) const;
+
+        /**
+         * @brief 取得从 base 到 target 的差分，不存在时生成并校验后保存在 root/deltas/xx/<base>-<target>.gz
+         * @throw std::runtime_error 读取、生成、校验或写入失败
+         */
+        delta_info delta(const package_info& base, const package_info& target);
+
+        [[nodiscard]] const std::filesystem::path& root() const noexcept {
+            return root_;
+        }
+
+    private:
+        struct index_entry {
+            std::int64_t mtime;
+            package_info info;
+        };
+
+        package_info store(const std::filesystem::path& source);
+        void load_index();
+        void save_index() const;
+
+        std::filesystem::path root_;
+        std::mutex mutex_;
+        // 源文件绝对路径 -> 入库记录
+        std::unordered_map<std::string, index_entry> index_;
+        bool index_loaded_{false};
+    };
+}
@@ -0,0 +1,151 @@
+#include "package_stream.h"
+
+#include <SimpleBase64.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <zlib.h>
+
+namespace l2q_http {
+    struct gzip_base64_stream::impl {
+        enum struct stage { prefix, body, suffix, done };
+
+        std::ifstream file;
+        z_stream zs{};
+        // 文件已是 Gzip 格式，不经过 zlib
+        bool passthrough{false};
+        bool deflate_finished{false};
+        stage current{stage::prefix};
+
+        std::string prefix;
+        std::string suffix;
+
+        std::vector<char> input = std::vector<char>(chunk_size);
+        // 开头保留 2 字节，存放上一块未凑满 3 字节的压缩数据
+        std::vector<unsigned char> compressed = std::vector<unsigned char>(chunk_size + 2);
+        std::size_t carry{0};
+        std::string encoded = std::string(SimpleBase64::encoded_size(chunk_size + 2), '\0');
+
+        impl(const std::filesystem::path& path, std::string prefix_, std::string suffix_)
+            : file(path, std::ios::binary), passthrough(true), prefix(std::move(prefix_)), suffix(std::move(suffix_)) {
+            if (!file) {
+                throw std::runtime_error("failed to open package file");
+            }
+        }
+
+        impl(const std::filesystem::path& path, int level, std::string prefix_, std::string suffix_)
+            : file(path, std::ios::binary), prefix(std::move(prefix_)), suffix(std::move(suffix_)) {
+            if (!file) {
+                throw std::runtime_error("failed to open package file");
+            }
+
+            if (level != -1) {
+                level = std::clamp(level, 0, 9);
+            }
+
+            // 15 + 16 启用 Gzip 头部处理
+            if (deflateInit2(&zs, level, Z_DEFLATED, 15 | 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("failed to initialize deflate stream");
+            }
+        }
+
+        ~impl() {
+            if (!passthrough) {
+                deflateEnd(&zs);
+            }
+        }
+
+        // 直接读取下一块压缩数据，接在上一块剩余的字节之后
+        std::size_t read_next() {
+            file.read(reinterpret_cast<char*>(compressed.data() + carry), static_cast<std::streamsize>(compressed.size() - carry));
+            if (file.bad()) {
+                throw std::runtime_error("failed to read package file");
+            }
+            deflate_finished = !file;
+            return carry + static_cast<std::size_t>(file.gcount());
+        }
+
+        // 压缩下一块数据并编码，返回的内容可能为空（压缩器尚未产出数据）
+        std::string_view encode_next() {
+            if (passthrough) {
+                return encode_available(read_next());
+            }
+
+            zs.next_out = compressed.data() + carry;
+            zs.avail_out = static_cast<uInt>(compressed.size() - carry);
+
+            while (zs.avail_out != 0 && !deflate_finished) {
+                if (zs.avail_in == 0 && file) {
+                    file.read(input.data(), static_cast<std::streamsize>(input.size()));
+                    if (file.bad()) {
+                        throw std::runtime_error("failed to read package file");
+                    }
+                    zs.next_in = reinterpret_cast<const Bytef*>(input.data());
+                    zs.avail_in = static_cast<uInt>(file.gcount());
+                }
+
+                const int ret = deflate(&zs, file ? Z_NO_FLUSH : Z_FINISH);
+                if (ret == Z_STREAM_END) {
+                    deflate_finished = true;
+                } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                    throw std::runtime_error("deflate failed");
+                }
+            }
+
+            return encode_available(compressed.size() - zs.avail_out);
+        }
+
+        std::string_view encode_available(const std::size_t available) {
+            // 结束前只编码 3 的整数倍，剩余字节留到下一块
+            const std::size_t encodable = deflate_finished ? available : available / 3 * 3;
+            const std::size_t written = SimpleBase64::encode_into(compressed.data(), encodable, encoded.data());
+
+            carry = available - encodable;
+            std::memmove(compressed.data(), compressed.data() + encodable, carry);
+
+            return {encoded.data(), written};
+        }
+    };
+
+    gzip_base64_stream::gzip_base64_stream(const std::filesystem::path& file, int level, std::string prefix, std::string suffix)
+        : impl_(std::make_unique<impl>(file, level, std::move(prefix), std::move(suffix))) {}
+
+    gzip_base64_stream::gzip_base64_stream(std::unique_ptr<impl> impl) : impl_(std::move(impl)) {}
+
+    gzip_base64_stream gzip_base64_stream::precompressed(const std::filesystem::path& file, std::string prefix, std::string suffix) {
+        return gzip_base64_stream(std::make_unique<impl>(file, std::move(prefix), std::move(suffix)));
+    }
+
+    gzip_base64_stream::~gzip_base64_stream() = default;
+    gzip_base64_stream::gzip_base64_stream(gzip_base64_stream&&) noexcept = default;
+    gzip_base64_stream& gzip_base64_stream::operator=(gzip_base64_stream&&) noexcept = default;
+
+    std::string_view gzip_base64_stream::next() {
+        using stage = impl::stage;
+
+        while (true) {
+            switch (impl_->current) {
+                case stage::prefix:
+                    impl_->current = stage::body;
+                    if (!impl_->prefix.empty()) return impl_->prefix;
+                    break;
+                case stage::body:
+                    if (const auto chunk = impl_->encode_next(); !chunk.empty()) {
+                        return chunk;
+                    }
+                    if (impl_->deflate_finished) {
+                        impl_->current = stage::suffix;
+                    }
+                    break;
+                case stage::suffix:
+                    impl_->current = stage::done;
+                    if (!impl_->suffix.empty()) return impl_->suffix;
+                    break;
+                case stage::done:
+                    return {};
+            }
+        }
+    }
+}
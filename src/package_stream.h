@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace l2q_http {
+    /**
+     * @brief 文件 -> Gzip 压缩 -> Base64 编码 的流式管线。
+     *
+     * 每次调用 next() 读取一块文件数据，压缩后编码为 Base64 并返回，
+     * 跨块时不足 3 字节的压缩数据会保留到下一块再编码，输出与一次性
+     * SimpleBase64::encode(gzip_compress(file)) 完全一致。
+     * 输出前后分别附加 prefix 与 suffix，用于拼接 JSON 框架。
+     *
+     * 常驻内存约为 zlib 状态 (~256 KB) 加上三个 chunk_size 大小的缓冲区。
+     * 文件本身已是 Gzip 格式时使用 precompressed()，跳过压缩只做 Base64 编码。
+     */
+    class gzip_base64_stream {
+    public:
+        static constexpr std::size_t chunk_size = 64 * 1024;
+
+        /**
+         * @throw std::runtime_error 文件无法打开或 zlib 初始化失败
+         */
+        gzip_base64_stream(const std::filesystem::path& file, int level, std::string prefix, std::string suffix);
+
+        /**
+         * @brief 对已经压缩好的 Gzip 文件只做 Base64 编码
+         * @throw std::runtime_error 文件无法打开
+         */
+        static gzip_base64_stream precompressed(const std::filesystem::path& file, std::string prefix, std::string suffix);
+
+        ~gzip_base64_stream();
+
+        gzip_base64_stream(gzip_base64_stream&&) noexcept;
+        gzip_base64_stream& operator=(gzip_base64_stream&&) noexcept;
+
+        /**
+         * @brief 获取下一段输出
+         * @return 下一段数据，在下次调用前有效；全部输出完毕后返回空
+         * @throw std::runtime_error 读取文件或压缩失败
+         */
+        [[nodiscard]] std::string_view next();
+
+    private:
+        struct impl;
+        explicit gzip_base64_stream(std::unique_ptr<impl> impl);
+
+        std::unique_ptr<impl> impl_;
+    };
+}
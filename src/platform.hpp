@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include "heterogeneous.hpp"
+
+namespace l2q_http{
+// 支持的操作系统-架构
+enum struct os_arch : std::uint8_t{
+	windows_x64,
+	windows_x86,
+	windows_arm64,
+	linux_x64,
+	linux_arm64,
+	macos_x64,
+	macos_arm64,
+};
+
+template <>
+struct enum_names<os_arch>{
+	static constexpr std::array<std::string_view, 7> values{
+		"windows-x64",
+		"windows-x86",
+		"windows-arm64",
+		"linux-x64",
+		"linux-arm64",
+		"macos-x64",
+		"macos-arm64",
+	};
+};
+
+// 更新通道，无法识别时使用 stable
+enum struct release_channel : std::uint8_t{
+	stable,
+	beta,
+	nightly,
+};
+
+template <>
+struct enum_names<release_channel>{
+	static constexpr std::array<std::string_view, 3> values{
+		"stable",
+		"beta",
+		"nightly",
+	};
+};
+
+static_assert(parse_enum<os_arch>("linux-arm64") == os_arch::linux_arm64);
+static_assert(parse_enum<os_arch>("linux") == std::nullopt);
+static_assert(parse_enum<release_channel>("beta") == release_channel::beta);
+
+/**
+ * @brief 解析通道，留空或无法识别时为 stable
+ */
+constexpr release_channel parse_channel(const std::string_view name) noexcept{
+	return parse_enum<release_channel>(name).value_or(release_channel::stable);
+}
+} // namespace l2q_http
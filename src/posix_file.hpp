@@ -0,0 +1,111 @@
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace l2q_http{
+/**
+ * @brief 只读打开的文件描述符
+ */
+class readonly_file{
+public:
+	/**
+	 * @throw std::system_error 打开或 fstat 失败
+	 */
+	explicit readonly_file(const std::filesystem::path& path)
+		: fd_(::open(path.c_str(), O_RDONLY | O_CLOEXEC)){
+		if(fd_ < 0){
+			throw std::system_error(errno, std::generic_category(), "open " + path.string());
+		}
+
+		// 大小取自已打开的描述符，与之后发送的内容一致，不受路径被替换的影响
+		struct stat st{};
+		if(::fstat(fd_, &st) != 0){
+			const int error = errno;
+			::close(fd_);
+			throw std::system_error(error, std::generic_category(), "fstat " + path.string());
+		}
+		size_ = static_cast<std::size_t>(st.st_size);
+	}
+
+	readonly_file(const readonly_file&) = delete;
+	readonly_file& operator=(const readonly_file&) = delete;
+
+	readonly_file(readonly_file&& other) noexcept
+		: fd_(std::exchange(other.fd_, -1)), size_(other.size_){}
+
+	readonly_file& operator=(readonly_file&& other) noexcept{
+		std::swap(fd_, other.fd_);
+		std::swap(size_, other.size_);
+		return *this;
+	}
+
+	~readonly_file(){
+		if(fd_ >= 0) ::close(fd_);
+	}
+
+	[[nodiscard]] int native_handle() const noexcept{
+		return fd_;
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept{
+		return size_;
+	}
+
+private:
+	int fd_;
+	std::size_t size_{};
+};
+
+/**
+ * @brief 文件的只读内存映射
+ */
+class mapped_region{
+public:
+	/**
+	 * @throw std::system_error mmap 失败
+	 */
+	explicit mapped_region(const readonly_file& file)
+		: size_(file.size()){
+		if(size_ == 0) return;
+
+		data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file.native_handle(), 0);
+		if(data_ == MAP_FAILED){
+			data_ = nullptr;
+			throw std::system_error(errno, std::generic_category(), "mmap");
+		}
+		// 顺序读取，提示内核加大预读
+		::madvise(data_, size_, MADV_SEQUENTIAL);
+	}
+
+	mapped_region(const mapped_region&) = delete;
+	mapped_region& operator=(const mapped_region&) = delete;
+
+	~mapped_region(){
+		if(data_) ::munmap(data_, size_);
+	}
+
+	[[nodiscard]] const void* data() const noexcept{
+		return data_;
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept{
+		return size_;
+	}
+
+private:
+	void* data_{};
+	std::size_t size_;
+};
+} // namespace l2q_http
+
+#endif
@@ -0,0 +1,872 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+#include "atomic_file.hpp"
+#include "catalog_image.hpp"
+#include "package_store.h"
+#include "posix_file.hpp"
+#include "platform.hpp"
+#include "request_process.hpp"
+#include "response_dictionary.hpp"
+#include "response_spill.hpp"
+#include "sha256.h"
+
+namespace l2q_http{
+// 版本号打包为整数：最多 4 段，每段占 16 位，"1.2.3" -> 0x0001'0002'0003'0000，直接按整数比较大小
+using packed_version = std::uint64_t;
+
+inline std::optional<packed_version> pack_version(std::string_view str) noexcept{
+	packed_version packed = 0;
+	int segments = 0;
+	while(true){
+		std::uint16_t segment = 0;
+		const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), segment);
+		if(ec != std::errc{} || ++segments > 4) return std::nullopt;
+
+		packed |= packed_version{segment} << (16 * (4 - segments));
+		str.remove_prefix(static_cast<std::size_t>(ptr - str.data()));
+
+		if(str.empty()) return packed;
+		if(str.front() != '.') return std::nullopt;
+		str.remove_prefix(1);
+	}
+}
+
+/**
+ * @brief 清单中更新包路径对应的文件，路径相对于 base_dir
+ * @return 绝对路径或规范化后离开 base_dir 的路径（例如 "../x"）返回 std::nullopt
+ */
+inline std::optional<std::filesystem::path> package_path(const std::filesystem::path& base_dir, const std::string_view relative){
+	const std::filesystem::path path{relative};
+	if(path.empty() || path.has_root_name() || path.has_root_directory()){
+		return std::nullopt;
+	}
+	const auto normal = path.lexically_normal();
+	if(normal.empty() || *normal.begin() == ".."){
+		return std::nullopt;
+	}
+	return base_dir / normal;
+}
+
+// check_version 返回的 flags
+namespace release_flags{
+	constexpr std::uint8_t update_available = 1 << 0;
+	constexpr std::uint8_t major_update = 1 << 1;
+	constexpr std::uint8_t critical_fix = 1 << 2;
+}
+
+struct release{
+	packed_version version;
+	// 仅包含 major_update / critical_fix
+	std::uint8_t flags;
+	std::string version_string;
+	std::filesystem::path package;
+	// 更新包在存储中的对象，源文件不存在时为空
+	std::optional<package_info> stored;
+};
+
+/**
+ * @brief 更新接口响应的缓存策略
+ */
+enum struct cache_policy : std::uint8_t{
+	// POST 接口：允许客户端保存响应，但每次使用前必须用 ETag 重新验证
+	revalidate,
+	// 以 URL 为键的 GET 接口：CDN 与反向代理可以在短时间内直接复用，过期后用 ETag 重新验证
+	shared,
+};
+
+inline constexpr std::size_t cache_policy_count = 2;
+
+constexpr std::string_view cache_control(const cache_policy policy) noexcept{
+	return policy == cache_policy::shared ? "public, max-age=60" : "no-cache";
+}
+
+/**
+ * @brief 预先序列化好的 check_version 响应，按缓存策略各一份，指向快照持有的响应表
+ */
+struct precomputed_response{
+	std::string_view etag;
+	// 200 响应
+	std::array<std::string_view, cache_policy_count> ok;
+	// If-None-Match 匹配时发送的 304 响应
+	std::array<std::string_view, cache_policy_count> not_modified;
+};
+
+/**
+ * @brief 某个 (os-arch, channel) 下按版本升序排列的发布记录
+ */
+struct release_track{
+	// 版本号单独连续存放，二分查找时不必跨越 release 对象；指向快照的扁平数组或映射的镜像
+	std::span<const packed_version> versions;
+	// pending_flags[i] 为 releases[i..] 的 flags 按位或，即客户端低于 versions[i] 时需要知道的标志
+	std::span<const std::uint8_t> pending_flags;
+	std::vector<release> releases;
+	// 客户端版本 -> 预先序列化好的完整 check_version 响应
+	std::unordered_map<packed_version, precomputed_response> responses;
+
+	[[nodiscard]] const release* latest() const noexcept{
+		return releases.empty() ? nullptr : &releases.back();
+	}
+};
+
+struct version_answer{
+	// 该频道的最新发布，频道为空时为 nullptr
+	const release* latest;
+	std::uint8_t flags;
+};
+
+/**
+ * @brief check_version 的响应体
+ * @param client_version 频道为空时原样返回客户端版本
+ */
+inline nlohmann::json version_answer_json(const version_answer& answer, const std::string_view client_version){
+	return {
+		{"version", answer.latest ? std::string_view{answer.latest->version_string} : client_version},
+		{"flags", answer.flags},
+	};
+}
+
+/**
+ * @brief 发布目录的不可变快照
+ * 所有 (os-arch, channel) 的数据放在一个以枚举值为下标的扁平数组中，
+ * 构建完成后不再修改，可以被任意多个线程同时读取。
+ */
+class catalog_snapshot{
+public:
+	static constexpr std::size_t track_count = enum_count<os_arch> * enum_count<release_channel>;
+	// 每个 os-arch 预先生成响应的客户端版本数（取最新的若干个）
+	static constexpr std::size_t max_precomputed_versions = 256;
+
+	catalog_snapshot() = default;
+	// track 中的 span 指向快照自己的存储，不能复制
+	catalog_snapshot(const catalog_snapshot&) = delete;
+	catalog_snapshot& operator=(const catalog_snapshot&) = delete;
+
+	/**
+	 * @brief 从清单构建快照
+	 * @param manifest 清单 JSON，格式见 readme
+	 * @param base_dir 更新包相对路径的基准目录
+	 * @param generation 快照代数，每次发布递增
+	 * @param packages 更新包存储，为 nullptr 时不入库
+	 * @param spill 预先生成的响应表的磁盘副本，为 nullptr 时总是重新生成
+	 * @throw std::runtime_error 清单格式错误或更新包入库失败
+	 */
+	static std::shared_ptr<const catalog_snapshot> from_manifest(const nlohmann::json& manifest, const std::filesystem::path& base_dir, std::uint64_t generation,
+	                                                             package_store* packages = nullptr, response_spill* spill = nullptr){
+		auto snapshot = std::make_shared<catalog_snapshot>();
+		snapshot->generation_ = generation;
+
+		// 代数在每次启动时从 1 开始，实体标签改用清单内容的摘要，重启后仍然有效
+		const auto digest = sha256::hash(manifest.dump());
+		for(std::size_t i = 0; i < sizeof(snapshot->fingerprint_); ++i){
+			snapshot->fingerprint_ = snapshot->fingerprint_ << 8 | digest[i];
+		}
+
+		const auto& entries = manifest.at("releases");
+		if(!entries.is_array()){
+			throw std::runtime_error("manifest: 'releases' must be an array");
+		}
+
+		struct pending_release{
+			os_arch arch;
+			release_channel channel;
+			release value;
+		};
+		std::vector<pending_release> pending;
+		pending.reserve(entries.size());
+
+		for(const auto& entry : entries){
+			const auto version_string = entry.at("version").get<std::string>();
+			const auto version = pack_version(version_string);
+			if(!version){
+				throw std::runtime_error("manifest: invalid version '" + version_string + "'");
+			}
+
+			std::uint8_t flags = 0;
+			if(entry.value("major", false)) flags |= release_flags::major_update;
+			if(entry.value("critical", false)) flags |= release_flags::critical_fix;
+
+			const auto arch_name = entry.at("os-arch").get<std::string>();
+			const auto arch = parse_enum<os_arch>(arch_name);
+			if(!arch){
+				throw std::runtime_error("manifest: unsupported os-arch '" + arch_name + "'");
+			}
+
+			const auto channel_name = entry.value("channel", std::string{enum_name(release_channel::stable)});
+			const auto channel = parse_enum<release_channel>(channel_name);
+			if(!channel){
+				throw std::runtime_error("manifest: unsupported channel '" + channel_name + "'");
+			}
+
+			const auto package_name = entry.at("package").get<std::string>();
+			auto package = package_path(base_dir, package_name);
+			if(!package){
+				throw std::runtime_error("manifest: package path '" + package_name + "' is outside the release directory");
+			}
+			std::optional<package_info> stored;
+			if(packages && std::filesystem::is_regular_file(*package)){
+				stored = packages->ingest(*package);
+			}
+
+			pending.push_back({*arch, *channel, release{*version, flags, version_string, std::move(*package), std::move(stored)}});
+		}
+
+		std::ranges::sort(pending, [](const pending_release& a, const pending_release& b){
+			return std::tie(a.arch, a.channel, a.value.version) < std::tie(b.arch, b.channel, b.value.version);
+		});
+
+		// 按 (os-arch, channel) 排序后各个 track 在扁平数组中依次相连，顺序与 index() 一致
+		snapshot->versions_.reserve(pending.size());
+		for(auto& [arch, channel, value] : pending){
+			auto& track = snapshot->tracks_[index(arch, channel)];
+			if(!track.releases.empty() && track.releases.back().version == value.version){
+				throw std::runtime_error("manifest: duplicate release " + value.version_string);
+			}
+			snapshot->versions_.push_back(value.version);
+			track.releases.push_back(std::move(value));
+		}
+
+		snapshot->pending_flags_.resize(pending.size());
+		std::size_t end = 0;
+		for(const auto& track : snapshot->tracks_){
+			end += track.releases.size();
+			std::uint8_t flags = 0;
+			for(std::size_t i = track.releases.size(); i-- > 0;){
+				flags |= track.releases[i].flags;
+				snapshot->pending_flags_[end - track.releases.size() + i] = flags;
+			}
+		}
+
+		snapshot->bind_tracks(snapshot->versions_, snapshot->pending_flags_);
+		snapshot->precompute_responses(spill);
+		return snapshot;
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	/**
+	 * @brief 从二进制镜像加载快照（格式见 catalog_image.hpp），版本号与标志数组直接使用映射的内存
+	 * @param manifest_digest 当前清单文件内容的 SHA-256
+	 * @param spill 预先生成的响应表的磁盘副本，为 nullptr 时总是重新生成
+	 * @return 镜像不存在、已损坏、格式不兼容，或清单、更新包源文件在编译之后有变化时返回 nullptr
+	 */
+	static std::shared_ptr<const catalog_snapshot> from_image(const std::filesystem::path& path, const sha256::digest_type& manifest_digest, const std::uint64_t generation,
+	                                                          response_spill* spill = nullptr){
+		namespace image = catalog_image;
+		std::shared_ptr<const mapped_region> region;
+		try{
+			region = std::make_shared<const mapped_region>(readonly_file{path});
+		} catch(const std::system_error& e){
+			if(e.code() != std::errc::no_such_file_or_directory){
+				spdlog::warn("catalog image {} unreadable: {}", path.string(), e.what());
+			}
+			return nullptr;
+		}
+
+		const auto* base = static_cast<const char*>(region->data());
+		const auto size = region->size();
+		const auto stale = [&](const std::string_view reason){
+			spdlog::info("catalog image {} ignored: {}", path.string(), reason);
+			return nullptr;
+		};
+
+		image::header header;
+		if(size < sizeof(header)) return stale("truncated");
+		std::memcpy(&header, base, sizeof(header));
+		if(header.magic != image::magic || header.byte_order != image::byte_order_mark) return stale("not a catalog image");
+		if(header.version != image::format_version || header.track_count != track_count) return stale("incompatible format");
+		if(header.file_size != size) return stale("truncated");
+		if(header.manifest_digest != manifest_digest) return stale("manifest changed");
+
+		const auto count = header.release_count;
+		const auto fits = [&](const std::uint64_t offset, const std::uint64_t bytes){
+			return offset % 8 == 0 && offset <= size && bytes <= size - offset;
+		};
+		if(count > UINT32_MAX
+			|| !fits(header.tracks_offset, track_count * sizeof(image::track_entry))
+			|| !fits(header.versions_offset, count * sizeof(packed_version))
+			|| !fits(header.flags_offset, count)
+			|| !fits(header.records_offset, count * sizeof(image::release_record))
+			|| header.strings_offset > size || header.strings_size > size - header.strings_offset){
+			return stale("corrupt section table");
+		}
+		if(crc32_z(0, reinterpret_cast<const Bytef*>(base + sizeof(header)), size - sizeof(header)) != header.checksum){
+			return stale("checksum mismatch");
+		}
+
+		const auto* tracks = reinterpret_cast<const image::track_entry*>(base + header.tracks_offset);
+		const auto* records = reinterpret_cast<const image::release_record*>(base + header.records_offset);
+		const std::string_view strings{base + header.strings_offset, header.strings_size};
+		const auto string = [&](const image::string_ref ref){
+			return strings.substr(std::min<std::size_t>(ref.offset, strings.size()), ref.length);
+		};
+
+		auto snapshot = std::make_shared<catalog_snapshot>();
+		snapshot->generation_ = generation;
+		snapshot->fingerprint_ = header.fingerprint;
+
+		std::uint64_t first = 0;
+		for(std::size_t t = 0; t < track_count; ++t){
+			if(tracks[t].first != first || tracks[t].count > count - first) return stale("corrupt track table");
+			auto& releases = snapshot->tracks_[t].releases;
+			releases.reserve(tracks[t].count);
+			for(std::size_t i = first; i < first + tracks[t].count; ++i){
+				const auto& record = records[i];
+				const auto version = reinterpret_cast<const packed_version*>(base + header.versions_offset)[i];
+				auto package = std::filesystem::path{string(record.package)};
+
+				// 入库记录只在源文件未变化时有效，与 package_store::ingest 的判断一致
+				const auto current = image::stamp(package);
+				if(record.stored ? current != record.source : current.has_value()){
+					return stale("package " + package.string() + " changed");
+				}
+
+				std::optional<package_info> stored;
+				if(record.stored){
+					// 与 package_store::ingest 一致：存储中的对象被删除时重新入库
+					auto object = std::filesystem::path{string(record.object)};
+					if(std::error_code ec; !std::filesystem::exists(object, ec)){
+						return stale("object " + object.string() + " missing");
+					}
+					stored = package_info{sha256::to_hex(record.sha256), record.size, record.compressed_size, std::move(object)};
+				}
+				releases.push_back(release{version, record.flags, std::string{string(record.version_string)}, std::move(package), std::move(stored)});
+			}
+			first += tracks[t].count;
+		}
+		if(first != count) return stale("corrupt track table");
+
+		snapshot->bind_tracks({reinterpret_cast<const packed_version*>(base + header.versions_offset), count},
+			{reinterpret_cast<const std::uint8_t*>(base + header.flags_offset), count});
+		snapshot->image_ = std::move(region);
+		snapshot->precompute_responses(spill);
+		return snapshot;
+	}
+
+	/**
+	 * @brief 把快照编译为二进制镜像写入 path，临时文件加重命名，写入过程中不影响正在使用旧镜像的进程
+	 * @param manifest_digest 构建快照所用清单文件内容的 SHA-256
+	 * @throw std::exception 写入失败
+	 */
+	void save_image(const std::filesystem::path& path, const sha256::digest_type& manifest_digest) const{
+		namespace image = catalog_image;
+		const auto count = release_count();
+
+		image::header header{};
+		header.magic = image::magic;
+		header.version = image::format_version;
+		header.byte_order = image::byte_order_mark;
+		header.track_count = track_count;
+		header.release_count = count;
+		header.manifest_digest = manifest_digest;
+		header.fingerprint = fingerprint_;
+		header.tracks_offset = sizeof(header);
+		header.versions_offset = image::align(header.tracks_offset + track_count * sizeof(image::track_entry));
+		header.flags_offset = header.versions_offset + count * sizeof(packed_version);
+		header.records_offset = image::align(header.flags_offset + count);
+		header.strings_offset = header.records_offset + count * sizeof(image::release_record);
+
+		std::array<image::track_entry, track_count> tracks{};
+		std::vector<image::release_record> records;
+		records.reserve(count);
+		image::string_table strings;
+		for(std::size_t t = 0; t < track_count; ++t){
+			tracks[t] = {static_cast<std::uint32_t>(records.size()), static_cast<std::uint32_t>(tracks_[t].releases.size())};
+			for(const auto& r : tracks_[t].releases){
+				image::release_record record{};
+				record.version_string = strings.intern(r.version_string);
+				record.package = strings.intern(r.package.native());
+				record.flags = r.flags;
+				if(r.stored){
+					const auto source = image::stamp(r.package);
+					if(!source){
+						throw std::runtime_error("package " + r.package.string() + " disappeared");
+					}
+					record.stored = 1;
+					record.source = *source;
+					record.size = r.stored->size;
+					record.compressed_size = r.stored->compressed_size;
+					record.object = strings.intern(r.stored->object.native());
+					for(std::size_t i = 0; i < record.sha256.size(); ++i){
+						std::from_chars(r.stored->sha256.data() + 2 * i, r.stored->sha256.data() + 2 * i + 2, record.sha256[i], 16);
+					}
+				}
+				records.push_back(record);
+			}
+		}
+		header.strings_size = strings.data().size();
+		header.file_size = header.strings_offset + header.strings_size;
+
+		std::string bytes(header.file_size, '\0');
+		std::memcpy(bytes.data() + header.tracks_offset, tracks.data(), sizeof(tracks));
+		for(std::size_t t = 0; t < track_count; ++t){
+			const auto& track = tracks_[t];
+			std::memcpy(bytes.data() + header.versions_offset + tracks[t].first * sizeof(packed_version), track.versions.data(), track.versions.size_bytes());
+			std::memcpy(bytes.data() + header.flags_offset + tracks[t].first, track.pending_flags.data(), track.pending_flags.size_bytes());
+		}
+		std::memcpy(bytes.data() + header.records_offset, records.data(), count * sizeof(image::release_record));
+		std::memcpy(bytes.data() + header.strings_offset, strings.data().data(), header.strings_size);
+		header.checksum = static_cast<std::uint32_t>(crc32_z(0, reinterpret_cast<const Bytef*>(bytes.data() + sizeof(header)), bytes.size() - sizeof(header)));
+		std::memcpy(bytes.data(), &header, sizeof(header));
+
+		write_file_atomic(path, bytes);
+	}
+#endif
+
+	[[nodiscard]] std::uint64_t generation() const noexcept{
+		return generation_;
+	}
+
+	/**
+	 * @brief 清单内容的 64 位摘要，清单不变时快照的所有响应都不变
+	 */
+	[[nodiscard]] std::uint64_t fingerprint() const noexcept{
+		return fingerprint_;
+	}
+
+	/**
+	 * @brief 预先生成的响应表在 response_spill 中的键
+	 */
+	[[nodiscard]] std::string spill_key() const{
+		return fmt::format("check/{:016x}", fingerprint_);
+	}
+
+	/**
+	 * @brief check_version 响应的强实体标签，由清单摘要与请求的 (os-arch, channel, 版本) 决定
+	 */
+	[[nodiscard]] std::string version_etag(const os_arch arch, const release_channel channel, const packed_version client) const{
+		return fmt::format("\"{:016x}-{}-{}-{:x}\"", fingerprint_, enum_name(arch), enum_name(channel), client);
+	}
+
+	/**
+	 * @brief 清单中出现过的 os-arch，其余的视为未知
+	 */
+	[[nodiscard]] bool has_arch(const os_arch arch) const noexcept{
+		for(std::size_t channel = 0; channel < enum_count<release_channel>; ++channel){
+			if(!track(arch, static_cast<release_channel>(channel)).releases.empty()) return true;
+		}
+		return false;
+	}
+
+	/**
+	 * @brief 该 os-arch 下没有此通道的发布时回退到 stable
+	 */
+	[[nodiscard]] release_channel resolve_channel(const os_arch arch, const release_channel channel) const noexcept{
+		return track(arch, channel).releases.empty() ? release_channel::stable : channel;
+	}
+
+	/**
+	 * @brief 两个快照的清单与所有更新包的内容是否都相同，相同时没有必要重新发布
+	 */
+	[[nodiscard]] bool same_content(const catalog_snapshot& other) const noexcept{
+		if(fingerprint_ != other.fingerprint_) return false;
+		for(std::size_t i = 0; i < tracks_.size(); ++i){
+			const auto& a = tracks_[i].releases;
+			const auto& b = other.tracks_[i].releases;
+			if(a.size() != b.size()) return false;
+			for(std::size_t j = 0; j < a.size(); ++j){
+				if(a[j].stored.has_value() != b[j].stored.has_value()) return false;
+				if(a[j].stored && a[j].stored->sha256 != b[j].stored->sha256) return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 所有发布的更新包源文件路径
+	 */
+	[[nodiscard]] std::vector<std::filesystem::path> package_paths() const{
+		std::vector<std::filesystem::path> paths;
+		for(const auto& t : tracks_){
+			for(const auto& r : t.releases){
+				paths.push_back(r.package);
+			}
+		}
+		return paths;
+	}
+
+	[[nodiscard]] std::size_t release_count() const noexcept{
+		std::size_t count = 0;
+		for(const auto& t : tracks_) count += t.releases.size();
+		return count;
+	}
+
+	[[nodiscard]] const release_track& track(const os_arch arch, const release_channel channel) const noexcept{
+		return tracks_[index(arch, channel)];
+	}
+
+	/**
+	 * @brief 计算 check_version 的结果
+	 */
+	[[nodiscard]] version_answer check(const os_arch arch, const release_channel channel, const packed_version client) const noexcept{
+		const auto& t = track(arch, channel);
+		const auto newer = std::ranges::upper_bound(t.versions, client);
+		if(newer == t.versions.end()){
+			return {t.latest(), 0};
+		}
+
+		const auto index = static_cast<std::size_t>(newer - t.versions.begin());
+		return {t.latest(), static_cast<std::uint8_t>(release_flags::update_available | t.pending_flags[index])};
+	}
+
+	/**
+	 * @brief 对每个 (os-arch, channel) 最新发布的更新包对象调用 fn，同一对象可能出现多次
+	 */
+	template <std::invocable<const package_info&> Fn>
+	void for_each_latest(Fn&& fn) const{
+		for(const auto& t : tracks_){
+			if(const auto* latest = t.latest(); latest && latest->stored){
+				fn(*latest->stored);
+			}
+		}
+	}
+
+	/**
+	 * @brief 查找预先生成的完整 check_version 响应，客户端版本不在已知范围内时返回 nullptr
+	 */
+	[[nodiscard]] const precomputed_response* precomputed(const os_arch arch, const release_channel channel, const packed_version client) const noexcept{
+		const auto& responses = track(arch, channel).responses;
+		if(const auto it = responses.find(client); it != responses.end()){
+			return &it->second;
+		}
+		return nullptr;
+	}
+
+private:
+	/**
+	 * @brief 预先生成的响应表中的一项，偏移量相对于表的起始
+	 */
+	struct response_entry{
+		std::uint32_t track;
+		std::uint32_t etag_offset;
+		packed_version version;
+		std::uint32_t etag_size;
+		std::array<std::uint32_t, cache_policy_count> ok_offset;
+		std::array<std::uint32_t, cache_policy_count> ok_size;
+		std::array<std::uint32_t, cache_policy_count> not_modified_offset;
+		std::array<std::uint32_t, cache_policy_count> not_modified_size;
+	};
+
+	/**
+	 * @brief 取得 已知客户端版本 × os-arch × channel 的完整 200 与 304 响应字节
+	 * 响应表只由清单内容决定，以指纹为键保存在 spill 中：存在时直接映射，否则生成后写入
+	 */
+	void precompute_responses(response_spill* spill){
+		const auto key = spill_key();
+		if(spill){
+			if(auto table = spill->load(key); table && bind_responses(std::move(table))){
+				return;
+			}
+		}
+
+		auto table = make_response_bytes(serialize_responses());
+		bind_responses(table);
+		if(spill){
+			spill->save(key, *table);
+		}
+	}
+
+	/**
+	 * @brief 生成响应表：std::uint64_t 项数，response_entry[项数]，之后是所有响应字节
+	 * 已知客户端版本取该 os-arch 下所有频道出现过的版本，客户端可能在频道之间切换
+	 */
+	std::string serialize_responses() const{
+		std::vector<response_entry> entries;
+		std::string bytes;
+		const auto append = [&](const std::string_view part){
+			const auto offset = static_cast<std::uint32_t>(bytes.size());
+			bytes.append(part);
+			return offset;
+		};
+
+		std::vector<packed_version> known;
+		for(std::size_t a = 0; a < enum_count<os_arch>; ++a){
+			const auto arch = static_cast<os_arch>(a);
+			known.clear();
+			for(std::size_t c = 0; c < enum_count<release_channel>; ++c){
+				const auto& versions = track(arch, static_cast<release_channel>(c)).versions;
+				known.insert(known.end(), versions.begin(), versions.end());
+			}
+			std::ranges::sort(known);
+			known.erase(std::unique(known.begin(), known.end()), known.end());
+			if(known.size() > max_precomputed_versions){
+				known.erase(known.begin(), known.end() - max_precomputed_versions);
+			}
+
+			for(std::size_t c = 0; c < enum_count<release_channel>; ++c){
+				const auto channel = static_cast<release_channel>(c);
+				if(track(arch, channel).releases.empty()) continue;
+
+				for(const auto version : known){
+					const auto body = version_answer_json(check(arch, channel, version), {}).dump();
+					const auto etag = version_etag(arch, channel, version);
+					response_entry entry{};
+					entry.track = static_cast<std::uint32_t>(index(arch, channel));
+					entry.version = version;
+					entry.etag_size = static_cast<std::uint32_t>(etag.size());
+					entry.etag_offset = append(etag);
+					for(std::size_t p = 0; p < cache_policy_count; ++p){
+						const auto policy = cache_control(static_cast<cache_policy>(p));
+						const auto headers = fmt::format("ETag: {}\r\nCache-Control: {}\r\nVary: {}\r\n", etag, policy, negotiated_vary);
+						const auto ok = serialize_response(status_code::ok, "application/json", headers, body);
+						const auto not_modified = serialize_not_modified(etag, policy, negotiated_vary);
+						entry.ok_size[p] = static_cast<std::uint32_t>(ok.size());
+						entry.ok_offset[p] = append(ok);
+						entry.not_modified_size[p] = static_cast<std::uint32_t>(not_modified.size());
+						entry.not_modified_offset[p] = append(not_modified);
+					}
+					entries.push_back(entry);
+				}
+			}
+		}
+
+		const std::uint64_t count = entries.size();
+		const auto head = sizeof(count) + entries.size() * sizeof(response_entry);
+		if(head + bytes.size() > UINT32_MAX){
+			throw std::length_error("precomputed responses too large");
+		}
+		for(auto& entry : entries){
+			const auto shift = static_cast<std::uint32_t>(head);
+			entry.etag_offset += shift;
+			for(std::size_t p = 0; p < cache_policy_count; ++p){
+				entry.ok_offset[p] += shift;
+				entry.not_modified_offset[p] += shift;
+			}
+		}
+
+		std::string table(head, '\0');
+		std::memcpy(table.data(), &count, sizeof(count));
+		std::memcpy(table.data() + sizeof(count), entries.data(), entries.size() * sizeof(response_entry));
+		table += bytes;
+		return table;
+	}
+
+	/**
+	 * @brief 让各个 track 的 responses 指向响应表中的字节，快照持有响应表
+	 * @return 表格式错误时返回 false，此时 responses 保持为空
+	 */
+	bool bind_responses(response_bytes table){
+		const std::string_view bytes = *table;
+		std::uint64_t count = 0;
+		if(bytes.size() < sizeof(count)) return false;
+		std::memcpy(&count, bytes.data(), sizeof(count));
+		if(count > (bytes.size() - sizeof(count)) / sizeof(response_entry)) return false;
+
+		const auto part = [&](const std::uint32_t offset, const std::uint32_t size, std::string_view& out){
+			if(offset > bytes.size() || size > bytes.size() - offset) return false;
+			out = bytes.substr(offset, size);
+			return true;
+		};
+		for(std::uint64_t i = 0; i < count; ++i){
+			response_entry entry;
+			std::memcpy(&entry, bytes.data() + sizeof(count) + i * sizeof(response_entry), sizeof(entry));
+
+			precomputed_response response;
+			bool valid = entry.track < track_count && part(entry.etag_offset, entry.etag_size, response.etag);
+			for(std::size_t p = 0; p < cache_policy_count && valid; ++p){
+				valid = part(entry.ok_offset[p], entry.ok_size[p], response.ok[p])
+					&& part(entry.not_modified_offset[p], entry.not_modified_size[p], response.not_modified[p]);
+			}
+			if(!valid){
+				for(auto& t : tracks_) t.responses.clear();
+				return false;
+			}
+			tracks_[entry.track].responses.insert_or_assign(entry.version, response);
+		}
+		responses_ = std::move(table);
+		return true;
+	}
+
+	/**
+	 * @brief 让每个 track 指向扁平数组中属于它的一段，各 track 按 index() 顺序相连
+	 */
+	void bind_tracks(const std::span<const packed_version> versions, const std::span<const std::uint8_t> pending_flags) noexcept{
+		std::size_t first = 0;
+		for(auto& t : tracks_){
+			t.versions = versions.subspan(first, t.releases.size());
+			t.pending_flags = pending_flags.subspan(first, t.releases.size());
+			first += t.releases.size();
+		}
+	}
+
+	static constexpr std::size_t index(const os_arch arch, const release_channel channel) noexcept{
+		return static_cast<std::size_t>(arch) * enum_count<release_channel> + static_cast<std::size_t>(channel);
+	}
+
+	std::uint64_t generation_{};
+	std::uint64_t fingerprint_{};
+	std::array<release_track, track_count> tracks_{};
+	// 从清单构建时 track 的版本号与标志所在的存储；从镜像加载时为空，image_ 保持映射有效
+	std::vector<packed_version> versions_;
+	std::vector<std::uint8_t> pending_flags_;
+	std::shared_ptr<const void> image_;
+	// 预先生成的响应表，track 的 responses 指向其中的字节
+	response_bytes responses_;
+};
+
+/**
+ * @brief 发布目录
+ * 请求线程通过 snapshot() 取得当前快照并在整个请求期间持有；发布新版本时构建新快照后原子替换，
+ * 读取方不会被阻塞，旧快照在最后一个持有者释放后销毁（RCU）。
+ */
+class release_catalog{
+public:
+	/**
+	 * @param packages 加载清单时将更新包入库的存储，为 nullptr 时不入库
+	 * @param image 发布目录的二进制镜像（见 catalog_image.hpp），为空时每次都解析清单
+	 * @param spill 预先生成的响应表的磁盘副本，为 nullptr 时每次构建快照都重新生成
+	 */
+	explicit release_catalog(package_store* packages = nullptr, std::filesystem::path image = {}, response_spill* spill = nullptr)
+		: current_(catalog_snapshot::from_manifest({{"releases", nlohmann::json::array()}}, {}, 0)), packages_(packages), image_(std::move(image)), spill_(spill){}
+
+	[[nodiscard]] std::shared_ptr<const catalog_snapshot> snapshot() const noexcept{
+		return current_.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief 读取清单文件，构建并发布新快照
+	 * 镜像与清单、更新包源文件一致时直接映射镜像，否则解析清单并重新编译镜像
+	 * @throw std::exception 读取或解析失败，此时当前快照保持不变
+	 */
+	std::shared_ptr<const catalog_snapshot> load_manifest(const std::filesystem::path& path){
+		const auto text = read_manifest_text(path);
+		const auto digest = sha256::hash(text);
+		const auto generation = next_generation();
+
+		std::shared_ptr<const catalog_snapshot> snapshot;
+#if defined(__unix__) || defined(__APPLE__)
+		if(!image_.empty()){
+			snapshot = catalog_snapshot::from_image(image_, digest, generation, spill_);
+		}
+#endif
+		if(snapshot){
+			spdlog::info("release catalog loaded from image {}", image_.string());
+		} else{
+			snapshot = catalog_snapshot::from_manifest(nlohmann::json::parse(text), path.parent_path(), generation, packages_, spill_);
+			save_image(*snapshot, digest);
+		}
+		publish(snapshot);
+		return snapshot;
+	}
+
+	/**
+	 * @brief 解析清单并编译镜像，不发布（--compile-catalog）
+	 * @throw std::exception 读取、解析、入库或写入失败
+	 */
+	std::shared_ptr<const catalog_snapshot> compile_image(const std::filesystem::path& path){
+		const auto text = read_manifest_text(path);
+		auto snapshot = build(nlohmann::json::parse(text), path.parent_path());
+#if defined(__unix__) || defined(__APPLE__)
+		snapshot->save_image(image_, sha256::hash(text));
+#else
+		throw std::runtime_error("catalog images are not supported on this platform");
+#endif
+		return snapshot;
+	}
+
+	/**
+	 * @brief 把快照写入镜像，失败只记录日志（下次启动回退到解析清单）
+	 * @param manifest_digest 构建快照所用清单文件内容的 SHA-256
+	 */
+	void save_image(const catalog_snapshot& snapshot, const sha256::digest_type& manifest_digest) const noexcept{
+#if defined(__unix__) || defined(__APPLE__)
+		if(image_.empty()) return;
+		try{
+			snapshot.save_image(image_, manifest_digest);
+			spdlog::debug("release catalog image {} written", image_.string());
+		} catch(const std::exception& e){
+			spdlog::warn("failed to write catalog image {}: {}", image_.string(), e.what());
+		}
+#endif
+	}
+
+	/**
+	 * @brief 读取清单文件的原始内容，其 SHA-256 用于判断镜像是否过期
+	 * @throw std::runtime_error 读取失败
+	 */
+	static std::string read_manifest_text(const std::filesystem::path& path){
+		std::ifstream file(path, std::ios::binary);
+		if(!file){
+			throw std::runtime_error("failed to open manifest " + path.string());
+		}
+		std::ostringstream text;
+		text << file.rdbuf();
+		return std::move(text).str();
+	}
+
+	/**
+	 * @brief 读取并解析清单文件
+	 * @throw std::exception 读取或解析失败
+	 */
+	static nlohmann::json read_manifest(const std::filesystem::path& path){
+		return nlohmann::json::parse(read_manifest_text(path));
+	}
+
+	/**
+	 * @brief 构建新快照（包括更新包入库）但不发布，可以在任意线程调用
+	 * @throw std::runtime_error 清单格式错误或更新包入库失败
+	 */
+	[[nodiscard]] std::shared_ptr<const catalog_snapshot> build(const nlohmann::json& manifest, const std::filesystem::path& base_dir){
+		return catalog_snapshot::from_manifest(manifest, base_dir, next_generation(), packages_, spill_);
+	}
+
+	void publish(std::shared_ptr<const catalog_snapshot> snapshot){
+		spdlog::info("release catalog generation {} published ({} releases)",
+			snapshot->generation(), snapshot->release_count());
+		current_.store(snapshot, std::memory_order_release);
+		if(spill_){
+			// 旧快照的响应表已经映射，删除文件不影响仍在使用它的请求
+			spill_->retain_if("check/", [key = snapshot->spill_key()](const std::string_view k){
+				return k == key;
+			});
+		}
+
+		for(const auto& listener : listeners_){
+			listener(*snapshot);
+		}
+	}
+
+	/**
+	 * @brief 注册发布新快照后的回调，例如清空依赖旧快照的缓存
+	 * 需要在开始处理请求之前注册，回调在调用 publish 的线程上执行
+	 */
+	void on_publish(std::function<void(const catalog_snapshot&)> listener){
+		listeners_.push_back(std::move(listener));
+	}
+
+	[[nodiscard]] std::uint64_t next_generation() noexcept{
+		return generation_.fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+
+private:
+
+	std::atomic<std::shared_ptr<const catalog_snapshot>> current_;
+	package_store* packages_;
+	std::filesystem::path image_;
+	response_spill* spill_;
+	std::vector<std::function<void(const catalog_snapshot&)>> listeners_;
+	std::atomic<std::uint64_t> generation_{0};
+};
+} // namespace l2q_http
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <asio.hpp>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include "release_catalog.hpp"
+#include "request_process.hpp"
+#include "sha256.h"
+
+namespace l2q_http{
+/**
+ * @brief GET /update/subscribe 的 Server-Sent Events 推送，代替客户端定时轮询 check_version
+ * 每个 (os-arch, channel) 是一个主题，持有订阅它的连接列表；发布的新快照改变了某个主题的最新发布时，
+ * 把序列化一次的事件写给该主题的所有连接，其余主题不受影响。
+ *
+ * 空闲连接的开销只有套接字本身与一个等待可读的操作（客户端关闭连接时触发）：没有逐连接的协程与计时器。
+ * 心跳由一个计时轮完成：连接在订阅时放进轮上的一格，计时器每 tick 前进一格并向该格中的连接发送注释行，
+ * 每个连接每 heartbeat_interval 收到一次心跳，代理与 NAT 不会因为空闲而断开连接；
+ * 上一次心跳在整个间隔内都没有写完的连接视为已停滞并关闭。
+ *
+ * 所有状态只在内部的 strand 上访问，refresh 与 subscribe 可以在任意线程调用。
+ */
+class release_notifier{
+public:
+	static constexpr std::chrono::seconds tick{1};
+	static constexpr std::size_t wheel_size = 30;
+	static constexpr auto heartbeat_interval = tick * wheel_size;
+
+	/**
+	 * @param executor 连接所在的执行器（事件循环）
+	 * @param max_subscribers 同时保持的连接数上限，超过时返回 503
+	 */
+	release_notifier(const asio::any_io_executor& executor, const release_catalog& catalog, const std::size_t max_subscribers = 100'000)
+		: strand_(asio::make_strand(executor)), catalog_(std::addressof(catalog)), max_subscribers_(max_subscribers), timer_(strand_){}
+
+	release_notifier(const release_notifier&) = delete;
+	release_notifier& operator=(const release_notifier&) = delete;
+
+	~release_notifier(){
+		for(auto& topic : topics_){
+			for(const auto& s : topic.subscribers){
+				std::error_code ec;
+				s->socket.close(ec);
+			}
+		}
+	}
+
+	/**
+	 * @brief 按当前快照生成各主题的事件并启动心跳
+	 */
+	void start(){
+		asio::dispatch(strand_, [this]{
+			refresh_topics();
+			schedule_tick();
+		});
+	}
+
+	/**
+	 * @brief 发布新快照后调用：最新发布有变化的主题向所有订阅者推送事件
+	 */
+	void refresh(){
+		asio::post(strand_, [this]{
+			refresh_topics();
+		});
+	}
+
+	/**
+	 * @brief GET /update/subscribe?os-arch=..&channel=..
+	 * 成功时连接转交给推送通道：先发送响应头与该主题当前的事件（请求的 Last-Event-ID 与之相同时省略），之后只发送新事件与心跳
+	 */
+	[[nodiscard]] request_result subscribe(request_args&& args){
+		if(args.method != http_method::get){
+			return request_result{{{"reason", "method not allowed"}}, status_code::method_not_allowed};
+		}
+
+		const auto* arch_name = args.query.try_find("os-arch");
+		const auto arch = arch_name ? parse_enum<os_arch>(*arch_name) : std::nullopt;
+		if(!arch){
+			return request_result{{{"reason", "unknown arch"}}, status_code::bad_request};
+		}
+		const auto* channel_name = args.query.try_find("channel");
+		const auto channel = parse_channel(channel_name ? std::string_view{*channel_name} : std::string_view{});
+
+		if(subscribers_.load(std::memory_order_relaxed) >= max_subscribers_){
+			rejected_.fetch_add(1, std::memory_order_relaxed);
+			return request_result{{{"reason", "too many subscribers"}}, status_code::service_unavailable};
+		}
+
+		const auto* last_event_id = args.headers.try_find("last-event-id");
+		return request_result{
+			.upgrade = [this, topic = index(*arch, channel), last_event_id = last_event_id ? *last_event_id : std::string{}](asio::ip::tcp::socket&& socket){
+				asio::post(strand_, [this, topic, last_event_id, socket = std::move(socket)]() mutable{
+					add(topic, std::move(socket), last_event_id);
+				});
+			},
+		};
+	}
+
+	[[nodiscard]] nlohmann::json metrics() const{
+		return {
+			{"subscribers", subscribers_.load(std::memory_order_relaxed)},
+			{"events", events_.load(std::memory_order_relaxed)},
+			{"heartbeats", heartbeats_.load(std::memory_order_relaxed)},
+			{"stalled", stalled_.load(std::memory_order_relaxed)},
+			{"rejected", rejected_.load(std::memory_order_relaxed)},
+		};
+	}
+
+private:
+	static constexpr std::string_view response_head =
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: text/event-stream\r\n"
+		"Cache-Control: no-store\r\n"
+		"Connection: keep-alive\r\n"
+		"X-Accel-Buffering: no\r\n"
+		"\r\n"
+		"retry: 10000\n\n";
+	static constexpr std::string_view heartbeat = ":\n\n";
+
+	struct subscriber : std::enable_shared_from_this<subscriber>{
+		explicit subscriber(asio::ip::tcp::socket&& s) noexcept
+			: socket(std::move(s)){}
+
+		asio::ip::tcp::socket socket;
+		// 在主题列表与计时轮格子中的位置，移除时与末尾交换
+		std::uint32_t topic{};
+		std::uint32_t topic_position{};
+		std::uint32_t slot{};
+		std::uint32_t slot_position{};
+		bool writing{false};
+		// 写入期间主题有了新事件，写完后补发
+		bool outdated{false};
+		// 上一次心跳时仍在写入
+		bool stalled{false};
+		bool closed{false};
+	};
+
+	using subscriber_ptr = std::shared_ptr<subscriber>;
+
+	struct topic_state{
+		// 完整的事件（id、event 与 data 行），主题没有发布时为空
+		std::shared_ptr<const std::string> event{std::make_shared<const std::string>()};
+		std::string id;
+		std::string data;
+		std::vector<subscriber_ptr> subscribers;
+	};
+
+	static constexpr std::size_t index(const os_arch arch, const release_channel channel) noexcept{
+		return static_cast<std::size_t>(arch) * enum_count<release_channel> + static_cast<std::size_t>(channel);
+	}
+
+	void refresh_topics(){
+		const auto snapshot = catalog_->snapshot();
+		for(std::size_t a = 0; a < enum_count<os_arch>; ++a){
+			for(std::size_t c = 0; c < enum_count<release_channel>; ++c){
+				const auto arch = static_cast<os_arch>(a);
+				const auto channel = snapshot->resolve_channel(arch, static_cast<release_channel>(c));
+				const auto* latest = snapshot->track(arch, channel).latest();
+				auto& topic = topics_[index(arch, static_cast<release_channel>(c))];
+				if(!latest){
+					// 没有可以通知的发布，已连接的客户端保持上一次收到的状态
+					continue;
+				}
+
+				nlohmann::json data{
+					{"os-arch", enum_name(arch)},
+					{"channel", enum_name(channel)},
+					{"version", latest->version_string},
+					{"flags", latest->flags},
+				};
+				if(latest->stored){
+					data["hash"] = latest->stored->hash();
+				}
+				auto serialized = data.dump();
+				if(serialized == topic.data){
+					continue;
+				}
+
+				// 事件 id 由内容决定：快照代数在每次启动时从 1 开始，不能用于比较重启前后的事件
+				topic.id = sha256::to_hex(sha256::hash(serialized)).substr(0, 16);
+				topic.event = std::make_shared<const std::string>(fmt::format("id: {}\nevent: release\ndata: {}\n\n", topic.id, serialized));
+				topic.data = std::move(serialized);
+				for(const auto& s : topic.subscribers){
+					push(s);
+				}
+			}
+		}
+	}
+
+	void add(const std::size_t topic_index, asio::ip::tcp::socket&& socket, const std::string& last_event_id){
+		auto s = std::make_shared<subscriber>(std::move(socket));
+		auto& topic = topics_[topic_index];
+		s->topic = static_cast<std::uint32_t>(topic_index);
+		s->topic_position = static_cast<std::uint32_t>(topic.subscribers.size());
+		topic.subscribers.push_back(s);
+		// 放在刚经过的格子，整整一个间隔后收到第一次心跳
+		s->slot = static_cast<std::uint32_t>((cursor_ + wheel_size - 1) % wheel_size);
+		s->slot_position = static_cast<std::uint32_t>(wheel_[s->slot].size());
+		wheel_[s->slot].push_back(s.get());
+		subscribers_.fetch_add(1, std::memory_order_relaxed);
+
+		// 客户端不会在推送通道上发送数据：可读即表示连接已关闭（或客户端违反了协议）
+		s->socket.async_wait(asio::ip::tcp::socket::wait_read, asio::bind_executor(strand_, [this, s](const std::error_code&){
+			remove(*s);
+		}));
+
+		auto event = topic.event;
+		const bool resume = !last_event_id.empty() && last_event_id == topic.id;
+		const std::array buffers{asio::buffer(response_head), asio::buffer(resume ? std::string_view{} : std::string_view{*event})};
+		write(s, buffers, std::move(event));
+	}
+
+	void push(const subscriber_ptr& s){
+		if(s->writing){
+			s->outdated = true;
+			return;
+		}
+		auto event = topics_[s->topic].event;
+		const std::array buffers{asio::buffer(*event)};
+		write(s, buffers, std::move(event));
+		events_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @param owner 持有 buffers 引用的内存，写完前保持存活
+	 */
+	template <typename Buffers>
+	void write(const subscriber_ptr& s, const Buffers& buffers, std::shared_ptr<const std::string> owner){
+		s->writing = true;
+		asio::async_write(s->socket, buffers, asio::bind_executor(strand_, [this, s, owner = std::move(owner)](const std::error_code& ec, std::size_t){
+			s->writing = false;
+			s->stalled = false;
+			if(ec){
+				remove(*s);
+				return;
+			}
+			if(s->outdated && !s->closed){
+				s->outdated = false;
+				push(s);
+			}
+		}));
+	}
+
+	void schedule_tick(){
+		timer_.expires_after(tick);
+		timer_.async_wait([this](const std::error_code& ec){
+			if(ec){
+				return;
+			}
+			beat(wheel_[cursor_]);
+			cursor_ = (cursor_ + 1) % wheel_size;
+			schedule_tick();
+		});
+	}
+
+	void beat(const std::vector<subscriber*>& slot){
+		// remove 会修改格子，先收集停滞的连接
+		std::vector<subscriber*> stalled;
+		for(auto* s : slot){
+			if(!s->writing){
+				const std::array buffers{asio::buffer(heartbeat)};
+				write(s->shared_from_this(), buffers, nullptr);
+				heartbeats_.fetch_add(1, std::memory_order_relaxed);
+			} else if(s->stalled){
+				stalled.push_back(s);
+			} else{
+				s->stalled = true;
+			}
+		}
+		for(auto* s : stalled){
+			stalled_.fetch_add(1, std::memory_order_relaxed);
+			remove(*s);
+		}
+	}
+
+	void remove(subscriber& s){
+		if(s.closed){
+			return;
+		}
+		s.closed = true;
+		std::error_code ec;
+		s.socket.close(ec);
+
+		auto& slot = wheel_[s.slot];
+		slot[s.slot_position] = slot.back();
+		slot[s.slot_position]->slot_position = s.slot_position;
+		slot.pop_back();
+
+		// 最后移除主题列表中的所有权，此后 s 可能已被销毁
+		auto& list = topics_[s.topic].subscribers;
+		const auto position = s.topic_position;
+		list.back()->topic_position = position;
+		std::swap(list[position], list.back());
+		subscribers_.fetch_sub(1, std::memory_order_relaxed);
+		list.pop_back();
+	}
+
+	asio::strand<asio::any_io_executor> strand_;
+	const release_catalog* catalog_;
+	std::size_t max_subscribers_;
+	asio::steady_timer timer_;
+
+	// 以下只在 strand_ 上访问
+	std::array<topic_state, catalog_snapshot::track_count> topics_{};
+	std::array<std::vector<subscriber*>, wheel_size> wheel_{};
+	std::size_t cursor_{0};
+
+	std::atomic<std::size_t> subscribers_{0};
+	std::atomic<std::uint64_t> events_{0};
+	std::atomic<std::uint64_t> heartbeats_{0};
+	std::atomic<std::uint64_t> stalled_{0};
+	std::atomic<std::uint64_t> rejected_{0};
+};
+} // namespace l2q_http
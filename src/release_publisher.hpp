@@ -0,0 +1,334 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <asio.hpp>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include "atomic_file.hpp"
+#include "platform.hpp"
+#include "release_catalog.hpp"
+#include "request_process.hpp"
+#include "sha256.h"
+
+namespace l2q_http{
+/**
+ * @brief 发布流水线：向运行中的服务添加新的发布记录
+ * 在后台执行器上依次完成 校验 -> 更新包入库（SHA-256 与 Gzip）-> 构建快照（含预先生成的 check_version 响应）->
+ * 各个准备步骤（例如预先生成 fetch_latest 响应）-> 原子写回清单文件，全部完成后才替换目录快照，
+ * 请求线程不做任何冷计算。发布按提交顺序串行执行，任何一步失败时当前快照与清单文件都保持不变。
+ *
+ * 发布请求有两个来源：需要管理令牌的 POST /admin/releases，以及投递目录中的 *.json 文件；
+ * 清单文件被直接修改时由 reload 重新加载（见 manifest_watcher）。
+ */
+class release_publisher{
+public:
+	using prepare_step = std::function<void(const catalog_snapshot&)>;
+
+	/**
+	 * @brief 发布请求被拒绝，code 为对应的 HTTP 状态码
+	 */
+	class rejected : public std::runtime_error{
+	public:
+		rejected(const status_code code, const std::string& reason)
+			: std::runtime_error(reason), code_(code){}
+
+		[[nodiscard]] status_code code() const noexcept{
+			return code_;
+		}
+
+	private:
+		status_code code_;
+	};
+
+	/**
+	 * @param executor 执行发布的执行器（通常是线程池），发布在其上的 strand 中串行执行
+	 * @param manifest 清单文件，发布成功后写回
+	 * @param admin_token POST /admin/releases 要求的令牌（Authorization: Bearer <令牌>），为空时该接口关闭
+	 */
+	release_publisher(release_catalog& catalog, const asio::any_io_executor& executor, std::filesystem::path manifest, std::string admin_token = {})
+		: catalog_(std::addressof(catalog)), strand_(asio::make_strand(executor)), manifest_(std::move(manifest)), admin_token_(std::move(admin_token)){}
+
+	/**
+	 * @brief 注册发布前的准备步骤，按注册顺序在后台执行器上执行，抛出异常时放弃本次发布
+	 * 需要在提交第一次发布之前注册
+	 */
+	void on_prepare(prepare_step step){
+		prepare_steps_.push_back(std::move(step));
+	}
+
+	/**
+	 * @brief 提交一条发布记录（格式与清单中 releases 的元素相同），等待其发布完成
+	 * @throw rejected 记录无效或与已有发布重复
+	 * @throw std::exception 入库、准备或写回清单失败
+	 */
+	asio::awaitable<std::shared_ptr<const catalog_snapshot>> publish(nlohmann::json entry){
+		auto job = [this, entry = std::move(entry)]() -> asio::awaitable<std::shared_ptr<const catalog_snapshot>>{
+			co_return publish_now(entry);
+		};
+		auto snapshot = co_await asio::co_spawn(strand_, std::move(job), asio::use_awaitable);
+		co_return snapshot;
+	}
+
+	/**
+	 * @brief 重新读取清单文件，经过与发布相同的准备步骤后替换快照；清单与更新包的内容都没有变化时不发布
+	 * 与 publish 在同一个 strand 上串行执行
+	 * @return 是否发布了新快照
+	 * @throw std::exception 读取、解析、入库或准备失败，此时当前快照保持不变
+	 */
+	asio::awaitable<bool> reload(){
+		auto job = [this]() -> asio::awaitable<bool>{
+			co_return reload_now();
+		};
+		const bool published = co_await asio::co_spawn(strand_, std::move(job), asio::use_awaitable);
+		co_return published;
+	}
+
+	/**
+	 * @brief POST /admin/releases，只接受来自本机且携带管理令牌的请求
+	 * 经过同一主机上的反向代理时所有请求都来自本机，来源地址不能单独作为授权
+	 */
+	[[nodiscard]] request_result add_release(request_args&& args){
+		if(args.method != http_method::post){
+			return request_result{{{"reason", "method not allowed"}}, status_code::method_not_allowed};
+		}
+		if(admin_token_.empty()){
+			return request_result{{{"reason", "admin endpoint is disabled"}}, status_code::forbidden};
+		}
+		if(!args.remote_address.is_loopback()){
+			return request_result{{{"reason", "admin endpoint is local only"}}, status_code::forbidden};
+		}
+		const auto* authorization = args.headers.try_find("authorization");
+		if(!authorization || !authorized(*authorization)){
+			return request_result{{{"reason", "invalid admin token"}}, status_code::unauthorized};
+		}
+
+		return request_result{
+			.deferred = [this, entry = std::move(args.body)]{
+				return respond(entry);
+			},
+		};
+	}
+
+	/**
+	 * @brief 每隔 interval 扫描投递目录，按文件名顺序发布其中的 *.json（每个文件一条发布记录），
+	 * 成功后重命名为 *.json.done，失败时重命名为 *.json.failed
+	 */
+	void watch(std::filesystem::path drop_dir, const std::chrono::steady_clock::duration interval){
+		auto loop = [this, drop_dir = std::move(drop_dir), interval]() -> asio::awaitable<void>{
+			asio::steady_timer timer(strand_);
+			while(true){
+				scan(drop_dir);
+				timer.expires_after(interval);
+				co_await timer.async_wait(asio::use_awaitable);
+			}
+		};
+		asio::co_spawn(strand_, std::move(loop), asio::detached);
+	}
+
+	[[nodiscard]] nlohmann::json metrics() const{
+		return {
+			{"published", published_.load(std::memory_order_relaxed)},
+			{"failed", failed_.load(std::memory_order_relaxed)},
+			{"last_duration_us", last_duration_us_.load(std::memory_order_relaxed)},
+		};
+	}
+
+private:
+	/**
+	 * @brief 在 strand 上执行一次完整的发布
+	 */
+	std::shared_ptr<const catalog_snapshot> publish_now(const nlohmann::json& entry){
+		const auto start = std::chrono::steady_clock::now();
+		try{
+			validate(entry);
+
+			auto manifest = release_catalog::read_manifest(manifest_);
+			auto& releases = manifest.at("releases");
+			if(!releases.is_array()){
+				throw std::runtime_error("manifest: 'releases' must be an array");
+			}
+			for(const auto& existing : releases){
+				if(same_release(existing, entry)){
+					throw rejected(status_code::conflict, "release already exists");
+				}
+			}
+			releases.push_back(entry);
+
+			auto snapshot = catalog_->build(manifest, manifest_.parent_path());
+			for(const auto& step : prepare_steps_){
+				step(*snapshot);
+			}
+			const auto text = write_manifest(manifest);
+			catalog_->publish(snapshot);
+			catalog_->save_image(*snapshot, sha256::hash(text));
+
+			const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			last_duration_us_.store(static_cast<std::uint64_t>(elapsed.count()), std::memory_order_relaxed);
+			published_.fetch_add(1, std::memory_order_relaxed);
+			spdlog::info("published {} {} {} in {}ms", entry.at("os-arch").get<std::string>(), entry.value("channel", "stable"),
+				entry.at("version").get<std::string>(), elapsed.count() / 1000);
+			return snapshot;
+		} catch(...){
+			failed_.fetch_add(1, std::memory_order_relaxed);
+			throw;
+		}
+	}
+
+	bool reload_now(){
+		const auto text = release_catalog::read_manifest_text(manifest_);
+		auto snapshot = catalog_->build(nlohmann::json::parse(text), manifest_.parent_path());
+		if(snapshot->same_content(*catalog_->snapshot())){
+			return false;
+		}
+		for(const auto& step : prepare_steps_){
+			step(*snapshot);
+		}
+		catalog_->publish(snapshot);
+		// 镜像按读到的清单内容编译，下次启动时与清单一致即可直接映射
+		catalog_->save_image(*snapshot, sha256::hash(text));
+		return true;
+	}
+
+	asio::awaitable<response_bytes> respond(nlohmann::json entry){
+		auto body = nlohmann::json::object();
+		auto code = status_code::created;
+		try{
+			const auto snapshot = co_await publish(std::move(entry));
+			body = {{"generation", snapshot->generation()}, {"releases", snapshot->release_count()}};
+		} catch(const rejected& e){
+			code = e.code();
+			body = {{"reason", e.what()}};
+		} catch(const std::exception& e){
+			spdlog::error("publication failed: {}", e.what());
+			code = status_code::internal_server_error;
+			body = {{"reason", e.what()}};
+		}
+		co_return make_response_bytes(serialize_response(code, "application/json", {}, body.dump()));
+	}
+
+	void scan(const std::filesystem::path& drop_dir){
+		std::error_code ec;
+		std::vector<std::filesystem::path> pending;
+		for(const auto& file : std::filesystem::directory_iterator(drop_dir, ec)){
+			if(file.is_regular_file(ec) && file.path().extension() == ".json"){
+				pending.push_back(file.path());
+			}
+		}
+		std::ranges::sort(pending);
+
+		for(const auto& file : pending){
+			auto outcome = ".done";
+			try{
+				publish_now(release_catalog::read_manifest(file));
+			} catch(const std::exception& e){
+				spdlog::error("publication from {} failed: {}", file.string(), e.what());
+				outcome = ".failed";
+			}
+			std::filesystem::rename(file, file.string() + outcome, ec);
+			if(ec){
+				spdlog::error("failed to rename {}: {}", file.string(), ec.message());
+			}
+		}
+	}
+
+	/**
+	 * @brief 发布记录的格式与清单一致，更新包路径相对于清单所在目录，且必须已经存在
+	 */
+	void validate(const nlohmann::json& entry) const{
+		if(!entry.is_object()){
+			throw rejected(status_code::bad_request, "release must be an object");
+		}
+		for(const auto* key : {"version", "os-arch", "package"}){
+			const auto it = entry.find(key);
+			if(it == entry.end() || !it->is_string()){
+				throw rejected(status_code::bad_request, std::string{"missing string field '"} + key + "'");
+			}
+		}
+		if(!pack_version(entry.at("version").get<std::string>())){
+			throw rejected(status_code::bad_request, "invalid version");
+		}
+		if(!parse_enum<os_arch>(entry.at("os-arch").get<std::string>())){
+			throw rejected(status_code::bad_request, "unsupported os-arch");
+		}
+		if(const auto it = entry.find("channel"); it != entry.end() && (!it->is_string() || !parse_enum<release_channel>(it->get<std::string>()))){
+			throw rejected(status_code::bad_request, "unsupported channel");
+		}
+		for(const auto* key : {"major", "critical"}){
+			if(const auto it = entry.find(key); it != entry.end() && !it->is_boolean()){
+				throw rejected(status_code::bad_request, std::string{"'"} + key + "' must be a boolean");
+			}
+		}
+		const auto package = package_path(manifest_.parent_path(), entry.at("package").get<std::string>());
+		if(!package){
+			throw rejected(status_code::bad_request, "package must be a relative path inside the release directory");
+		}
+		if(!std::filesystem::is_regular_file(*package)){
+			throw rejected(status_code::bad_request, "package not found");
+		}
+	}
+
+	/**
+	 * @brief 比较 Authorization 头与管理令牌，比较时间与令牌内容无关
+	 */
+	[[nodiscard]] bool authorized(std::string_view authorization) const noexcept{
+		constexpr std::string_view scheme = "Bearer ";
+		if(!authorization.starts_with(scheme)){
+			return false;
+		}
+		authorization.remove_prefix(scheme.size());
+		if(authorization.size() != admin_token_.size()){
+			return false;
+		}
+		unsigned char difference = 0;
+		for(std::size_t i = 0; i < admin_token_.size(); ++i){
+			difference |= static_cast<unsigned char>(authorization[i] ^ admin_token_[i]);
+		}
+		return difference == 0;
+	}
+
+	/**
+	 * @brief 两条记录是否描述同一个发布（同一 os-arch、channel 下版本号相等）
+	 */
+	static bool same_release(const nlohmann::json& a, const nlohmann::json& b){
+		const auto field = [](const nlohmann::json& entry, const char* key, const std::string_view fallback){
+			const auto it = entry.find(key);
+			return it != entry.end() && it->is_string() ? it->get<std::string>() : std::string{fallback};
+		};
+		return field(a, "os-arch", {}) == field(b, "os-arch", {})
+			&& parse_channel(field(a, "channel", "stable")) == parse_channel(field(b, "channel", "stable"))
+			&& pack_version(field(a, "version", {})) == pack_version(field(b, "version", {}));
+	}
+
+	/**
+	 * @brief 先写临时文件再重命名，清单文件在任何时刻都是完整的
+	 * @return 写入的内容
+	 */
+	std::string write_manifest(const nlohmann::json& manifest) const{
+		auto text = manifest.dump(1);
+		text += '\n';
+		write_file_atomic(manifest_, text);
+		return text;
+	}
+
+	release_catalog* catalog_;
+	asio::strand<asio::any_io_executor> strand_;
+	std::filesystem::path manifest_;
+	std::string admin_token_;
+	std::vector<prepare_step> prepare_steps_;
+
+	std::atomic<std::uint64_t> published_{0};
+	std::atomic<std::uint64_t> failed_{0};
+	std::atomic<std::uint64_t> last_duration_us_{0};
+};
+} // namespace l2q_http
@@ -1,10 +1,18 @@
 #pragma once
 
+#include <charconv>
 #include <string>
 #include <string_view>
+#include <filesystem>
 #include <functional>
 #include <map>
+#include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+#include <asio/awaitable.hpp>
+#include <asio/ip/address.hpp>
+#include <asio/ip/tcp.hpp>
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 #include "heterogeneous.hpp"
@@ -13,13 +21,20 @@ namespace l2q_http{
 // 状态码枚举
 enum struct status_code : std::uint16_t{
 	ok = 200,
+	created = 201,
+	partial_content = 206,
+	not_modified = 304,
 	bad_request = 400,
 	unauthorized = 401,
 	forbidden = 403,
 	not_found = 404,
 	method_not_allowed = 405,
 	not_acceptable = 406,
+	conflict = 409,
+	payload_too_large = 413,
+	range_not_satisfiable = 416,
 	internal_server_error = 500,
+	service_unavailable = 503,
 };
 
 enum struct http_method {
@@ -33,16 +48,183 @@ enum struct http_method {
 	unknown
 };
 
+// 流式响应体：每次调用返回下一段数据（在下次调用前有效），返回空表示结束
+using body_stream = std::function<std::string_view()>;
+
+// 预先序列化好的完整响应字节；字节的所有者（字符串、目录快照或映射的文件）由 shared_ptr 的控制块持有
+using response_bytes = std::shared_ptr<const std::string_view>;
+
+/**
+ * @brief 取得字符串的所有权，包装为 response_bytes
+ */
+inline response_bytes make_response_bytes(std::string bytes){
+	struct owned{
+		std::string bytes;
+		std::string_view view;
+	};
+	auto holder = std::make_shared<owned>(std::move(bytes));
+	holder->view = holder->bytes;
+	return response_bytes(holder, &holder->view);
+}
+
+// 异步生成的完整响应：会话 co_await 其结果后按 request_result::raw 发送，等待期间不阻塞事件循环
+using deferred_response = std::function<asio::awaitable<response_bytes>()>;
+
 // 请求处理结果
 struct request_result{
 	nlohmann::json data{};
 	status_code code{status_code::ok};
+	// 非空时忽略 data，作为已序列化好的 JSON 响应体发送（仍经过压缩协商）
+	std::string body{};
+	// 非空时忽略 data，以 chunked 传输编码逐段发送
+	body_stream stream{};
+	// 非空时忽略 data，直接发送该文件的内容
+	std::filesystem::path file{};
+	std::string content_type{"application/json"};
+	// 附加的响应头
+	std::vector<std::pair<std::string, std::string>> headers{};
+	// 强实体标签（含引号），非空时发送 ETag 头，并在请求的 If-None-Match 匹配时以 304 代替响应体
+	std::string etag{};
+	// 非空时发送 Cache-Control 头
+	std::string cache_control{};
+	// 非空时忽略其余字段，直接发送这段预先序列化好的完整响应（状态行、响应头与响应体）
+	response_bytes raw{};
+	// 非空时忽略其余字段，等待其生成完整响应后发送
+	deferred_response deferred{};
+	// 非空时忽略其余字段，会话把连接交给它后结束，既不发送响应也不关闭连接（长连接推送）
+	std::function<void(asio::ip::tcp::socket&&)> upgrade{};
 };
 
+inline std::string status_line(const status_code code){
+	// 简单的状态码转字符串 (TODO 看需不需要使用magic enum)
+	if(code == status_code::ok) return "200 OK";
+	if(code == status_code::created) return "201 Created";
+	if(code == status_code::partial_content) return "206 Partial Content";
+	if(code == status_code::not_modified) return "304 Not Modified";
+	if(code == status_code::service_unavailable) return "503 Service Unavailable";
+	if(code == status_code::range_not_satisfiable) return "416 Range Not Satisfiable";
+	if(code == status_code::unauthorized) return "401 Unauthorized";
+	if(code == status_code::forbidden) return "403 Forbidden";
+	if(code == status_code::not_found) return "404 Not Found";
+	if(code == status_code::conflict) return "409 Conflict";
+	if(code == status_code::payload_too_large) return "413 Payload Too Large";
+	return fmt::format("{} Error", static_cast<int>(code));
+}
+
+/**
+ * @brief 序列化完整的 HTTP 响应
+ * @param extra_headers 附加的响应头，每行以 \r\n 结尾
+ */
+inline std::string serialize_response(const status_code code, const std::string_view content_type, const std::string_view extra_headers, const std::string_view body){
+	return fmt::format(
+		"HTTP/1.1 {}\r\n"
+		"Content-Type: {}\r\n"
+		"{}"
+		"Content-Length: {}\r\n"
+		"Connection: close\r\n"
+		"\r\n"
+		"{}",
+		status_line(code), content_type, extra_headers, body.size(), body
+	);
+}
+
+/**
+ * @brief 只序列化状态行与响应头，响应体由调用方随后追加或单独发送
+ * @param extra_headers 附加的响应头，每行以 \r\n 结尾
+ */
+inline std::string serialize_response_head(const status_code code, const std::string_view content_type, const std::string_view extra_headers, const std::uint64_t content_length){
+	return fmt::format(
+		"HTTP/1.1 {}\r\n"
+		"Content-Type: {}\r\n"
+		"{}"
+		"Content-Length: {}\r\n"
+		"Connection: close\r\n"
+		"\r\n",
+		status_line(code), content_type, extra_headers, content_length
+	);
+}
+
+/**
+ * @brief 判断 If-None-Match 是否匹配实体标签（弱比较，RFC 7232 3.2）
+ * @param if_none_match 请求头的值，例如 "\"a\", W/\"b\"" 或 "*"
+ * @param etag 当前的实体标签，含引号，可以带 W/ 前缀
+ */
+constexpr bool etag_matches(std::string_view if_none_match, std::string_view etag) noexcept{
+	const auto opaque = [](std::string_view tag){
+		while(!tag.empty() && (tag.front() == ' ' || tag.front() == '\t')) tag.remove_prefix(1);
+		while(!tag.empty() && (tag.back() == ' ' || tag.back() == '\t')) tag.remove_suffix(1);
+		if(tag.starts_with("W/")) tag.remove_prefix(2);
+		return tag;
+	};
+
+	etag = opaque(etag);
+	if(etag.empty()) return false;
+	if(opaque(if_none_match) == "*") return true;
+
+	while(!if_none_match.empty()){
+		const auto comma = if_none_match.find(',');
+		if(opaque(if_none_match.substr(0, comma)) == etag) return true;
+		if_none_match = comma == std::string_view::npos ? std::string_view{} : if_none_match.substr(comma + 1);
+	}
+	return false;
+}
+
+/**
+ * @brief 序列化 304 响应，只携带 ETag、Cache-Control 与 Vary（与 200 响应一致），没有响应体
+ */
+inline std::string serialize_not_modified(const std::string_view etag, const std::string_view cache_control, const std::string_view vary = {}){
+	std::string response = fmt::format("HTTP/1.1 {}\r\nETag: {}\r\n", status_line(status_code::not_modified), etag);
+	if(!cache_control.empty()) fmt::format_to(std::back_inserter(response), "Cache-Control: {}\r\n", cache_control);
+	if(!vary.empty()) fmt::format_to(std::back_inserter(response), "Vary: {}\r\n", vary);
+	response += "Connection: close\r\n\r\n";
+	return response;
+}
+
+/**
+ * @brief 解析查询字符串（name=value&...），按 application/x-www-form-urlencoded 解码，同名参数保留最后一个
+ */
+inline string_hash_map<std::string> parse_query(std::string_view query){
+	const auto decode = [](const std::string_view encoded){
+		std::string decoded;
+		decoded.reserve(encoded.size());
+		for(std::size_t i = 0; i < encoded.size(); ++i){
+			const char c = encoded[i];
+			unsigned value = 0;
+			if(c == '%' && i + 2 < encoded.size()
+				&& std::from_chars(encoded.data() + i + 1, encoded.data() + i + 3, value, 16).ptr == encoded.data() + i + 3){
+				decoded.push_back(static_cast<char>(value));
+				i += 2;
+			} else{
+				decoded.push_back(c == '+' ? ' ' : c);
+			}
+		}
+		return decoded;
+	};
+
+	string_hash_map<std::string> params;
+	while(!query.empty()){
+		const auto amp = query.find('&');
+		const auto pair = query.substr(0, amp);
+		query = amp == std::string_view::npos ? std::string_view{} : query.substr(amp + 1);
+		if(pair.empty()) continue;
+
+		const auto eq = pair.find('=');
+		params.insert_or_assign(decode(pair.substr(0, eq)), eq == std::string_view::npos ? std::string{} : decode(pair.substr(eq + 1)));
+	}
+	return params;
+}
 
 struct request_args{
 	http_method method{};
 	nlohmann::json body{};
+	// 请求头，键统一为小写
+	string_hash_map<std::string> headers{};
+	// 路径参数，对应路由中的 {name}
+	string_hash_map<std::string> params{};
+	// 查询参数，对应 URL 中 ? 之后的 name=value
+	string_hash_map<std::string> query{};
+	// 客户端地址
+	asio::ip::address remote_address{};
 };
 
 class request_handler{
@@ -53,13 +235,22 @@ public:
 
 	/**
 	* @brief 注册路由
-	* @param path: API路径 (e.g., "/api/login")
+	* @param path: API路径 (e.g., "/api/login")，以 {name} 表示的路径段会作为参数放入 request_args::params
 	* @param handler: 处理逻辑
 	*/
 	template <std::invocable<request_args&&> Fn>
 		requires (std::constructible_from<logic_func, Fn&&>)
 	bool route(std::string_view path, Fn&& handler){
-		return routes_.try_emplace(path, std::forward<Fn>(handler)).second;
+		if(path.find('{') == std::string_view::npos){
+			return routes_.try_emplace(path, std::forward<Fn>(handler)).second;
+		}
+
+		auto segments = split_path(path);
+		for(const auto& route : pattern_routes_){
+			if(route.segments == segments) return false;
+		}
+		pattern_routes_.push_back({std::move(segments), logic_func(std::forward<Fn>(handler))});
+		return true;
 	}
 
 	/**
@@ -69,10 +260,22 @@ public:
 	 * @return 状态码和响应数据
 	 */
 	[[nodiscard]] request_result process(std::string_view path, request_args&& request) const{
+		if(const auto question = path.find('?'); question != std::string_view::npos){
+			request.query = parse_query(path.substr(question + 1));
+			path = path.substr(0, question);
+		}
+
+		const logic_func* logic = nullptr;
 		if(auto it = routes_.find(path); it != routes_.end()){
+			logic = &it->second;
+		} else{
+			logic = match_pattern(path, request.params);
+		}
+
+		if(logic){
 			try{
 				spdlog::debug("processing logic for path: {}", path);
-				return it->second(std::move(request));
+				return (*logic)(std::move(request));
 			} catch(const std::exception& e){
 				spdlog::error("logic error at {}: {}", path, e.what());
 				return request_result{e.what(), status_code::internal_server_error};
@@ -84,6 +287,47 @@ public:
 	}
 
 private:
+	struct pattern_route{
+		std::vector<std::string> segments;
+		logic_func logic;
+	};
+
+	static std::vector<std::string> split_path(std::string_view path){
+		std::vector<std::string> segments;
+		while(!path.empty()){
+			const auto slash = path.find('/');
+			if(slash != 0){
+				segments.emplace_back(path.substr(0, slash));
+			}
+			path = slash == std::string_view::npos ? std::string_view{} : path.substr(slash + 1);
+		}
+		return segments;
+	}
+
+	const logic_func* match_pattern(const std::string_view path, string_hash_map<std::string>& params) const{
+		if(pattern_routes_.empty()) return nullptr;
+
+		const auto segments = split_path(path);
+		for(const auto& route : pattern_routes_){
+			if(route.segments.size() != segments.size()) continue;
+
+			bool matched = true;
+			for(std::size_t i = 0; i < segments.size() && matched; ++i){
+				const std::string_view pattern = route.segments[i];
+				if(pattern.size() >= 2 && pattern.front() == '{' && pattern.back() == '}'){
+					params.insert_or_assign(pattern.substr(1, pattern.size() - 2), segments[i]);
+				} else{
+					matched = pattern == segments[i];
+				}
+			}
+
+			if(matched) return &route.logic;
+			params.clear();
+		}
+		return nullptr;
+	}
+
 	string_hash_map<logic_func> routes_;
+	std::vector<pattern_route> pattern_routes_;
 };
 } // namespace l2q_http
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "heterogeneous.hpp"
+#include "request_process.hpp"
+
+namespace l2q_http{
+struct response_cache_config{
+	// 所有分片合计可以占用的字节数（按响应字节计）
+	std::size_t byte_budget{256 * 1024 * 1024};
+	// 分片数，每个分片有独立的锁与 LRU 链表，预算平均分配
+	std::size_t shard_count{8};
+};
+
+/**
+ * @brief 按字节预算淘汰的响应缓存
+ * 值是序列化好的完整响应（response_bytes）：命中时只增加引用计数，
+ * 多个会话同时发送同一份字节而不拷贝；被淘汰的条目在最后一个发送者结束后才释放。
+ * 键按哈希分到各个分片，每个分片各自按 LRU 淘汰。
+ */
+class response_cache{
+public:
+	using value_type = response_bytes;
+
+	explicit response_cache(const response_cache_config& config = {})
+		: shard_budget_(config.byte_budget / std::max<std::size_t>(config.shard_count, 1)){
+		shards_.resize(std::max<std::size_t>(config.shard_count, 1));
+		for(auto& shard : shards_){
+			shard = std::make_unique<cache_shard>();
+		}
+	}
+
+	/**
+	 * @brief 单个条目的大小上限，超过的响应不缓存
+	 */
+	[[nodiscard]] std::size_t max_entry_size() const noexcept{
+		return shard_budget_;
+	}
+
+	/**
+	 * @brief 查找条目，命中时将其移到 LRU 链表头部
+	 */
+	[[nodiscard]] value_type find(const std::string_view key){
+		auto& shard = shard_for(key);
+		std::lock_guard lock(shard.mutex);
+		if(auto* it = shard.index.try_find(key)){
+			shard.entries.splice(shard.entries.begin(), shard.entries, *it);
+			hits_.fetch_add(1, std::memory_order_relaxed);
+			return (*it)->value;
+		}
+		misses_.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	/**
+	 * @brief 条目是否存在，不改变 LRU 顺序也不计入命中率，供预热时跳过已有的条目
+	 */
+	[[nodiscard]] bool contains(const std::string_view key) const{
+		const auto& shard = *shards_[shard_index(key)];
+		std::lock_guard lock(shard.mutex);
+		return shard.index.contains(key);
+	}
+
+	/**
+	 * @brief 插入或替换条目，超出分片预算时从 LRU 链表尾部淘汰
+	 * @return 条目超过 max_entry_size() 未被缓存时返回 false
+	 */
+	bool insert(std::string key, value_type value){
+		const auto size = entry_size(key, value);
+		if(!value || size > shard_budget_){
+			return false;
+		}
+
+		auto& shard = shard_for(key);
+		std::lock_guard lock(shard.mutex);
+		if(auto* it = shard.index.try_find(key)){
+			remove(shard, *it);
+		}
+
+		shard.entries.push_front(entry{key, std::move(value)});
+		shard.index.insert_or_assign(std::move(key), shard.entries.begin());
+		shard.bytes += size;
+		bytes_.fetch_add(size, std::memory_order_relaxed);
+
+		while(shard.bytes > shard_budget_){
+			remove(shard, std::prev(shard.entries.end()));
+			evictions_.fetch_add(1, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 清空所有条目，例如发布目录更新之后
+	 */
+	void clear(){
+		for(auto& shard : shards_){
+			std::lock_guard lock(shard->mutex);
+			bytes_.fetch_sub(shard->bytes, std::memory_order_relaxed);
+			shard->entries.clear();
+			shard->index.clear();
+			shard->bytes = 0;
+		}
+		invalidations_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief 只保留键满足条件的条目，例如发布目录更新之后淘汰不再被引用的更新包
+	 * @return 移除的条目数
+	 */
+	template <std::predicate<std::string_view> Pred>
+	std::size_t retain_if(Pred keep){
+		std::size_t removed = 0;
+		for(auto& shard : shards_){
+			std::lock_guard lock(shard->mutex);
+			for(auto it = shard->entries.begin(); it != shard->entries.end();){
+				if(std::invoke(keep, std::string_view{it->key})){
+					++it;
+				} else{
+					remove(*shard, it++);
+					++removed;
+				}
+			}
+		}
+		invalidations_.fetch_add(1, std::memory_order_relaxed);
+		return removed;
+	}
+
+	/**
+	 * @brief 所有条目的副本（只复制 shared_ptr），例如关闭服务前写入磁盘；不改变 LRU 顺序
+	 */
+	[[nodiscard]] std::vector<std::pair<std::string, value_type>> entries() const{
+		std::vector<std::pair<std::string, value_type>> result;
+		for(const auto& shard : shards_){
+			std::lock_guard lock(shard->mutex);
+			for(const auto& e : shard->entries){
+				result.emplace_back(e.key, e.value);
+			}
+		}
+		return result;
+	}
+
+	[[nodiscard]] nlohmann::json metrics() const{
+		std::size_t entries = 0;
+		for(const auto& shard : shards_){
+			std::lock_guard lock(shard->mutex);
+			entries += shard->entries.size();
+		}
+		return {
+			{"hits", hits_.load(std::memory_order_relaxed)},
+			{"misses", misses_.load(std::memory_order_relaxed)},
+			{"evictions", evictions_.load(std::memory_order_relaxed)},
+			{"invalidations", invalidations_.load(std::memory_order_relaxed)},
+			{"entries", entries},
+			{"bytes_resident", bytes_.load(std::memory_order_relaxed)},
+			{"byte_budget", shard_budget_ * shards_.size()},
+		};
+	}
+
+private:
+	struct entry{
+		std::string key;
+		value_type value;
+	};
+
+	struct cache_shard{
+		mutable std::mutex mutex;
+		// 头部为最近使用
+		std::list<entry> entries;
+		string_hash_map<std::list<entry>::iterator> index;
+		std::size_t bytes{};
+	};
+
+	static std::size_t entry_size(const std::string_view key, const value_type& value) noexcept{
+		return key.size() + (value ? value->size() : 0);
+	}
+
+	[[nodiscard]] std::size_t shard_index(const std::string_view key) const noexcept{
+		return std::hash<std::string_view>{}(key) % shards_.size();
+	}
+
+	cache_shard& shard_for(const std::string_view key){
+		return *shards_[shard_index(key)];
+	}
+
+	void remove(cache_shard& shard, const std::list<entry>::iterator it){
+		const auto size = entry_size(it->key, it->value);
+		shard.bytes -= size;
+		bytes_.fetch_sub(size, std::memory_order_relaxed);
+		shard.index.erase(it->key);
+		shard.entries.erase(it);
+	}
+
+	std::size_t shard_budget_;
+	std::vector<std::unique_ptr<cache_shard>> shards_;
+
+	std::atomic<std::uint64_t> hits_{0};
+	std::atomic<std::uint64_t> misses_{0};
+	std::atomic<std::uint64_t> evictions_{0};
+	std::atomic<std::uint64_t> invalidations_{0};
+	std::atomic<std::size_t> bytes_{0};
+};
+} // namespace l2q_http
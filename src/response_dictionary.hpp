@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include "compress.h"
+
+namespace l2q_http{
+/**
+ * @brief deflate 预置字典
+ * id 随响应头 X-L2Q-Dictionary 下发，客户端据此选择解压所用的字典。
+ * 字典一旦发布便不可修改，调整内容时追加新版本。
+ */
+struct compression_dictionary{
+	std::string_view id;
+	std::string_view data;
+};
+
+inline constexpr std::string_view dictionary_header = "X-L2Q-Dictionary";
+
+// JSON 响应的编码按这两个请求头协商，无论最终是否压缩都需要在 Vary 中声明，共享缓存据此区分变体
+inline constexpr std::string_view negotiated_vary = "Accept-Encoding, X-L2Q-Dictionary";
+
+// 由 check_version / fetch_latest 常见响应整理而成。
+// deflate 引用距离越短编码越省，所以越常出现的片段放在越靠后的位置
+inline constexpr std::array response_dictionaries{
+	compression_dictionary{
+		"v1",
+		R"({"reason":"invalid json format"})"
+		R"({"reason":"resource not found"})"
+		R"({"reason":"unknown arch"})"
+		R"({"os-arch":"windows-x64","channel":"stable"})"
+		R"({"os-arch":"linux-x64","channel":"beta"})"
+		R"({"data":"","hash":""})"
+		R"({"flags":0,"version":"1.0.0"})"
+		R"({"flags":1,"version":"1.1"})"
+		R"({"flags":3,"version":"1.0"})"
+	},
+};
+
+/**
+ * @brief 按版本号查找字典，找不到返回 nullptr
+ */
+constexpr const compression_dictionary* find_dictionary(const std::string_view id) noexcept{
+	for(const auto& dictionary : response_dictionaries){
+		if(dictionary.id == id) return &dictionary;
+	}
+	return nullptr;
+}
+
+/**
+ * @brief 客户端解码：根据响应头 X-L2Q-Dictionary 给出的版本解压 Content-Encoding: deflate 的响应体
+ * @param body 响应体
+ * @param dictionary_id 响应头 X-L2Q-Dictionary 的值
+ * @param out 解压结果
+ * @return 字典版本未知时返回 inflate_status::invalid_data
+ */
+inline inflate_status decode_dictionary_response(const std::string_view body, const std::string_view dictionary_id, std::string& out, const inflate_limits& limits = {}) noexcept{
+	const auto* dictionary = find_dictionary(dictionary_id);
+	if(!dictionary){
+		return inflate_status::invalid_data;
+	}
+	return deflate_decompress(body, dictionary->data, limits, out);
+}
+} // namespace l2q_http
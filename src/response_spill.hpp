@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+#include "atomic_file.hpp"
+#include "catalog_image.hpp"
+#include "posix_file.hpp"
+#include "request_process.hpp"
+
+namespace l2q_http{
+/**
+ * @brief 预先生成的响应在磁盘上的副本，重启后不必重新生成
+ * 每个条目一个文件，文件名由键决定；键只由内容的摘要决定（例如更新包的 SHA-256、清单的指纹），
+ * 内容相同的条目只写一次，写入后不再修改。文件头记录格式版本、键与 CRC-32，
+ * 读取时映射到内存并校验，返回的 response_bytes 直接指向映射的内存，不拷贝；
+ * 格式版本不同或校验失败的文件视为不存在并删除。
+ *
+ * 不支持内存映射的平台上所有操作都是空操作。可被多个线程同时调用。
+ */
+class response_spill{
+public:
+	// 响应的序列化方式变化时递增，旧文件被忽略
+	static constexpr std::uint32_t format_version = 1;
+
+	/**
+	 * @throw std::filesystem::filesystem_error 无法创建目录
+	 */
+	explicit response_spill(std::filesystem::path directory)
+		: directory_(std::move(directory)){
+		std::filesystem::create_directories(directory_);
+	}
+
+	/**
+	 * @brief 写入条目，已存在时跳过；失败只记录日志
+	 * @return 是否写入了新文件
+	 */
+	bool save(const std::string_view key, const std::string_view bytes){
+#if defined(__unix__) || defined(__APPLE__)
+		const auto path = path_for(key);
+		std::error_code ec;
+		if(std::filesystem::exists(path, ec)){
+			return false;
+		}
+
+		file_header header{};
+		header.magic = magic;
+		header.version = format_version;
+		header.key_size = static_cast<std::uint32_t>(key.size());
+		header.size = bytes.size();
+		auto crc = crc32_z(0, reinterpret_cast<const Bytef*>(key.data()), key.size());
+		header.checksum = static_cast<std::uint32_t>(crc32_z(crc, reinterpret_cast<const Bytef*>(bytes.data()), bytes.size()));
+
+		std::string file(sizeof(header), '\0');
+		std::memcpy(file.data(), &header, sizeof(header));
+		file.reserve(sizeof(header) + key.size() + bytes.size());
+		file.append(key).append(bytes);
+		try{
+			write_file_atomic(path, file);
+		} catch(const std::exception& e){
+			spdlog::warn("failed to spill {}: {}", key, e.what());
+			return false;
+		}
+		saved_.fetch_add(1, std::memory_order_relaxed);
+		bytes_saved_.fetch_add(bytes.size(), std::memory_order_relaxed);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * @brief 映射并校验条目，不存在或已损坏时返回 nullptr
+	 */
+	[[nodiscard]] response_bytes load(const std::string_view key){
+#if defined(__unix__) || defined(__APPLE__)
+		const auto path = path_for(key);
+		std::shared_ptr<const mapped_region> region;
+		try{
+			region = std::make_shared<const mapped_region>(readonly_file{path});
+		} catch(const std::system_error&){
+			return nullptr;
+		}
+
+		const auto* base = static_cast<const char*>(region->data());
+		file_header header{};
+		bool valid = region->size() >= sizeof(header);
+		if(valid){
+			std::memcpy(&header, base, sizeof(header));
+			valid = header.magic == magic && header.version == format_version && header.key_size == key.size()
+				&& region->size() - sizeof(header) - key.size() == header.size
+				&& std::string_view{base + sizeof(header), key.size()} == key;
+		}
+		if(valid){
+			const auto crc = crc32_z(0, reinterpret_cast<const Bytef*>(base + sizeof(header)), region->size() - sizeof(header));
+			valid = crc == header.checksum;
+		}
+		if(!valid){
+			spdlog::warn("discarding corrupt or outdated spill {}", path.string());
+			std::error_code ec;
+			std::filesystem::remove(path, ec);
+			rejected_.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		struct mapped{
+			std::shared_ptr<const mapped_region> region;
+			std::string_view view;
+		};
+		auto holder = std::make_shared<mapped>(std::move(region));
+		holder->view = {base + sizeof(header) + key.size(), header.size};
+		loaded_.fetch_add(1, std::memory_order_relaxed);
+		return response_bytes(holder, &holder->view);
+#else
+		return nullptr;
+#endif
+	}
+
+	[[nodiscard]] bool contains(const std::string_view key) const{
+		std::error_code ec;
+		return std::filesystem::exists(path_for(key), ec);
+	}
+
+	/**
+	 * @brief 删除键以 prefix 开头且不满足条件的条目，例如不再被任何频道引用的更新包的响应
+	 * @return 删除的文件数
+	 */
+	template <std::predicate<std::string_view> Pred>
+	std::size_t retain_if(const std::string_view prefix, Pred keep){
+		const auto file_prefix = file_name(prefix);
+		std::size_t removed = 0;
+		std::error_code ec;
+		for(const auto& file : std::filesystem::directory_iterator(directory_, ec)){
+			const auto name = file.path().filename().string();
+			if(!name.starts_with(file_prefix) || !name.ends_with(extension)) continue;
+			if(std::invoke(keep, key_of(name))) continue;
+			if(std::filesystem::remove(file.path(), ec)) ++removed;
+		}
+		return removed;
+	}
+
+	[[nodiscard]] nlohmann::json metrics() const{
+		return {
+			{"saved", saved_.load(std::memory_order_relaxed)},
+			{"bytes_saved", bytes_saved_.load(std::memory_order_relaxed)},
+			{"loaded", loaded_.load(std::memory_order_relaxed)},
+			{"rejected", rejected_.load(std::memory_order_relaxed)},
+		};
+	}
+
+private:
+	static constexpr std::array<char, 8> magic{'L', '2', 'Q', 'S', 'P', 'I', 'L', 'L'};
+	static constexpr std::string_view extension = ".bin";
+
+	struct file_header{
+		std::array<char, 8> magic;
+		std::uint32_t version;
+		// 键与响应字节的 CRC-32
+		std::uint32_t checksum;
+		std::uint32_t key_size;
+		std::uint32_t reserved;
+		std::uint64_t size;
+	};
+
+	// 键中的 '/' 换成 '-'，其余字符（十六进制摘要、字母与数字）原样保留
+	static std::string file_name(const std::string_view key){
+		std::string name{key};
+		std::ranges::replace(name, '/', '-');
+		return name;
+	}
+
+	static std::string key_of(std::string_view name){
+		name.remove_suffix(extension.size());
+		std::string key{name};
+		std::ranges::replace(key, '-', '/');
+		return key;
+	}
+
+	[[nodiscard]] std::filesystem::path path_for(const std::string_view key) const{
+		return directory_ / (file_name(key) + std::string{extension});
+	}
+
+	std::filesystem::path directory_;
+
+	std::atomic<std::uint64_t> saved_{0};
+	std::atomic<std::uint64_t> bytes_saved_{0};
+	std::atomic<std::uint64_t> loaded_{0};
+	std::atomic<std::uint64_t> rejected_{0};
+};
+} // namespace l2q_http
@@ -0,0 +1,245 @@
+#include "sha256.h"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define SHA256_X86 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#    define SHA256_TARGET
+#  else
+#    define SHA256_TARGET __attribute__((target("sha,sse4.1")))
+#  endif
+#else
+#  define SHA256_X86 0
+#endif
+
+namespace {
+    constexpr std::array<std::uint32_t, 64> round_constants{
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    constexpr std::array<std::uint32_t, 8> initial_state{
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+
+    using compress_fn = void (*)(std::uint32_t* state, const std::uint8_t* data, std::size_t blocks) noexcept;
+
+    void compress_scalar(std::uint32_t* state, const std::uint8_t* data, std::size_t blocks) noexcept {
+        for (; blocks != 0; --blocks, data += 64) {
+            std::uint32_t w[64];
+            for (int i = 0; i < 16; ++i) {
+                w[i] = std::uint32_t{data[i * 4]} << 24 | std::uint32_t{data[i * 4 + 1]} << 16
+                     | std::uint32_t{data[i * 4 + 2]} << 8 | std::uint32_t{data[i * 4 + 3]};
+            }
+            for (int i = 16; i < 64; ++i) {
+                const auto s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                const auto s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            auto a = state[0], b = state[1], c = state[2], d = state[3];
+            auto e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; ++i) {
+                const auto t1 = h + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) + ((e & f) ^ (~e & g)) + round_constants[i] + w[i];
+                const auto t2 = (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+    }
+
+#if SHA256_X86
+    // Intel SHA Extensions：每条 sha256rnds2 完成两轮，消息扩展由 sha256msg1/sha256msg2 完成
+    SHA256_TARGET
+    void compress_shani(std::uint32_t* state, const std::uint8_t* data, std::size_t blocks) noexcept {
+        const __m128i byteswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+        // 调整为指令要求的 ABEF / CDGH 排列
+        __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+        __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+        __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+        state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+        for (; blocks != 0; --blocks, data += 64) {
+            const __m128i abef = state0;
+            const __m128i cdgh = state1;
+            __m128i w[4];
+
+            // 每次 4 轮，w[i % 4] 为当前 4 个消息字
+            for (int i = 0; i < 16; ++i) {
+                if (i < 4) {
+                    w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16)), byteswap);
+                }
+
+                __m128i msg = _mm_add_epi32(w[i % 4], _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_constants.data() + i * 4)));
+                state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+
+                if (i >= 3 && i <= 14) {
+                    auto& next = w[(i + 1) % 4];
+                    next = _mm_add_epi32(next, _mm_alignr_epi8(w[i % 4], w[(i + 3) % 4], 4));
+                    next = _mm_sha256msg2_epu32(next, w[i % 4]);
+                }
+
+                msg = _mm_shuffle_epi32(msg, 0x0E);
+                state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+                if (i >= 1 && i <= 12) {
+                    auto& previous = w[(i + 3) % 4];
+                    previous = _mm_sha256msg1_epu32(previous, w[i % 4]);
+                }
+            }
+
+            state0 = _mm_add_epi32(state0, abef);
+            state1 = _mm_add_epi32(state1, cdgh);
+        }
+
+        tmp = _mm_shuffle_epi32(state0, 0x1B);
+        state1 = _mm_shuffle_epi32(state1, 0xB1);
+        state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+        state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+    }
+
+    bool cpu_has_shani() noexcept {
+        int info[4];
+#  if defined(_MSC_VER) && !defined(__clang__)
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        const bool sse41 = info[2] & (1 << 19);
+        __cpuidex(info, 7, 0);
+#  else
+        unsigned max_leaf = 0, ebx = 0, ecx = 0, edx = 0;
+        __asm__("cpuid" : "=a"(max_leaf), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0), "c"(0));
+        if (max_leaf < 7) return false;
+        unsigned eax1 = 0;
+        __asm__("cpuid" : "=a"(eax1), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1), "c"(0));
+        const bool sse41 = ecx & (1u << 19);
+        unsigned eax7 = 0;
+        __asm__("cpuid" : "=a"(eax7), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(7), "c"(0));
+        info[1] = static_cast<int>(ebx);
+#  endif
+        return sse41 && (info[1] & (1 << 29));
+    }
+#endif
+
+    struct implementation {
+        compress_fn compress;
+        std::string_view name;
+    };
+
+    const implementation scalar{compress_scalar, "scalar"};
+#if SHA256_X86
+    const implementation shani{compress_shani, "sha-ni"};
+#endif
+
+    // 进程启动时通过 cpuid 检测一次
+    const bool has_shani = [] {
+#if SHA256_X86
+        return cpu_has_shani();
+#else
+        return false;
+#endif
+    }();
+
+    const implementation& select(sha256::backend which) noexcept {
+#if SHA256_X86
+        if (which == sha256::backend::sha_ni) {
+            return shani;
+        }
+#endif
+        return scalar;
+    }
+}
+
+sha256::sha256() noexcept : sha256(has_shani ? backend::sha_ni : backend::scalar) {}
+
+sha256::sha256(backend which) noexcept : backend_(which), state_(initial_state), buffer_{}, buffered_(0), total_(0) {}
+
+void sha256::update(std::span<const std::byte> data) noexcept {
+    const auto compress = select(backend_).compress;
+    auto* bytes = reinterpret_cast<const std::uint8_t*>(data.data());
+    std::size_t size = data.size();
+    total_ += size;
+
+    if (buffered_ != 0) {
+        const std::size_t take = std::min(size, buffer_.size() - buffered_);
+        std::memcpy(buffer_.data() + buffered_, bytes, take);
+        buffered_ += take;
+        bytes += take;
+        size -= take;
+
+        if (buffered_ < buffer_.size()) {
+            return;
+        }
+        compress(state_.data(), buffer_.data(), 1);
+        buffered_ = 0;
+    }
+
+    // 完整的块直接从输入处理，不经过内部缓冲区
+    if (const std::size_t blocks = size / 64; blocks != 0) {
+        compress(state_.data(), bytes, blocks);
+        bytes += blocks * 64;
+        size -= blocks * 64;
+    }
+
+    std::memcpy(buffer_.data(), bytes, size);
+    buffered_ = size;
+}
+
+sha256::digest_type sha256::finish() noexcept {
+    const std::uint64_t bit_length = total_ * 8;
+
+    // 填充：0x80，若干个 0，最后 8 字节为大端序的比特长度
+    std::array<std::uint8_t, 72> padding{};
+    padding[0] = 0x80;
+    const std::size_t pad = (buffered_ < 56 ? 56 : 120) - buffered_;
+    for (int i = 0; i < 8; ++i) {
+        padding[pad + i] = static_cast<std::uint8_t>(bit_length >> (56 - 8 * i));
+    }
+    update(std::as_bytes(std::span{padding.data(), pad + 8}));
+
+    digest_type digest;
+    for (std::size_t i = 0; i < state_.size(); ++i) {
+        digest[i * 4] = static_cast<std::uint8_t>(state_[i] >> 24);
+        digest[i * 4 + 1] = static_cast<std::uint8_t>(state_[i] >> 16);
+        digest[i * 4 + 2] = static_cast<std::uint8_t>(state_[i] >> 8);
+        digest[i * 4 + 3] = static_cast<std::uint8_t>(state_[i]);
+    }
+
+    *this = sha256{backend_};
+    return digest;
+}
+
+std::string sha256::to_hex(const digest_type& digest) {
+    constexpr std::string_view hex = "0123456789abcdef";
+    std::string result(digest.size() * 2, '\0');
+    for (std::size_t i = 0; i < digest.size(); ++i) {
+        result[i * 2] = hex[digest[i] >> 4];
+        result[i * 2 + 1] = hex[digest[i] & 0x0F];
+    }
+    return result;
+}
+
+std::string_view sha256::implementation() noexcept {
+    return select(has_shani ? backend::sha_ni : backend::scalar).name;
+}
+
+bool sha256::supported(backend which) noexcept {
+    return which == backend::scalar || has_shani;
+}
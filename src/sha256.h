@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief 增量计算 SHA-256。
+ *
+ * 压缩函数在启动时按 CPU 能力选择：支持 SHA-NI 时使用硬件指令，否则使用标量实现。
+ */
+class sha256 {
+public:
+    using digest_type = std::array<std::uint8_t, 32>;
+
+    enum class backend { scalar, sha_ni };
+
+    sha256() noexcept;
+
+    /**
+     * @brief 用指定的实现计算，which 必须满足 supported（测试与基准用它比较各实现）
+     */
+    explicit sha256(backend which) noexcept;
+
+    void update(std::span<const std::byte> data) noexcept;
+
+    void update(std::string_view data) noexcept {
+        update(std::as_bytes(std::span{data.data(), data.size()}));
+    }
+
+    /**
+     * @brief 结束计算并返回摘要，之后对象回到初始状态
+     */
+    [[nodiscard]] digest_type finish() noexcept;
+
+    /**
+     * @brief 一次性计算摘要
+     */
+    [[nodiscard]] static digest_type hash(std::string_view data) noexcept {
+        sha256 hasher;
+        hasher.update(data);
+        return hasher.finish();
+    }
+
+    /**
+     * @brief 摘要的小写十六进制表示
+     */
+    [[nodiscard]] static std::string to_hex(const digest_type& digest);
+
+    /**
+     * @brief 当前使用的实现名称，用于日志
+     */
+    [[nodiscard]] static std::string_view implementation() noexcept;
+
+    /**
+     * @brief 当前 CPU 是否支持该实现
+     */
+    [[nodiscard]] static bool supported(backend which) noexcept;
+
+private:
+    backend backend_;
+    std::array<std::uint32_t, 8> state_;
+    std::array<std::uint8_t, 64> buffer_;
+    std::size_t buffered_;
+    std::uint64_t total_;
+};
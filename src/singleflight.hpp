@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <asio.hpp>
+#include <nlohmann/json.hpp>
+#include "heterogeneous.hpp"
+
+namespace l2q_http{
+/**
+ * @brief 请求合并：同一个键同时只执行一次构建，其余调用者 co_await 同一个结果
+ * 构建函数投递到 build_executor（通常是线程池）执行，不阻塞事件循环；
+ * 等待方各自持有一个定时器，构建完成时在其所在的执行器上取消定时器将其唤醒，
+ * 超时未完成的等待方放弃等待，构建本身不受影响。
+ */
+template <typename Value>
+class singleflight{
+public:
+	/**
+	 * @param build_executor 执行构建函数的执行器，不能是等待方所在的单线程事件循环
+	 * @param timeout 等待构建结果的最长时间
+	 */
+	singleflight(asio::any_io_executor build_executor, const std::chrono::steady_clock::duration timeout)
+		: build_executor_(std::move(build_executor)), timeout_(timeout){}
+
+	/**
+	 * @brief 取得键对应的结果，没有进行中的构建时发起一次
+	 * @throw std::system_error asio::error::timed_out 等待超时
+	 * @throw 构建函数抛出的异常，同一次构建的所有等待方都会收到
+	 */
+	template <std::invocable Fn>
+		requires std::convertible_to<std::invoke_result_t<Fn>, Value>
+	asio::awaitable<Value> run(std::string key, Fn build){
+		std::shared_ptr<flight> current;
+		bool leader = false;
+		{
+			std::lock_guard lock(mutex_);
+			if(const auto* existing = flights_.try_find(key)){
+				current = *existing;
+			} else{
+				current = std::make_shared<flight>();
+				flights_.insert_or_assign(key, current);
+				leader = true;
+			}
+		}
+		(leader ? builds_ : coalesced_).fetch_add(1, std::memory_order_relaxed);
+
+		auto timer = std::make_shared<asio::steady_timer>(co_await asio::this_coro::executor, timeout_);
+		bool waiting = false;
+		{
+			std::lock_guard lock(current->mutex);
+			if(!current->done){
+				current->waiters.push_back(timer);
+				waiting = true;
+			}
+		}
+
+		if(leader){
+			asio::post(build_executor_, [this, current, key = std::move(key), build = std::move(build)]() mutable{
+				complete(*current, key, std::move(build));
+			});
+		}
+
+		if(waiting){
+			std::error_code ec;
+			co_await timer->async_wait(asio::redirect_error(asio::use_awaitable, ec));
+		}
+
+		std::lock_guard lock(current->mutex);
+		if(!current->done){
+			std::erase(current->waiters, timer);
+			timeouts_.fetch_add(1, std::memory_order_relaxed);
+			throw std::system_error(asio::error::timed_out);
+		}
+		if(current->error){
+			std::rethrow_exception(current->error);
+		}
+		co_return current->value;
+	}
+
+	[[nodiscard]] nlohmann::json metrics() const{
+		std::size_t in_flight = 0;
+		{
+			std::lock_guard lock(mutex_);
+			in_flight = flights_.size();
+		}
+		return {
+			{"builds", builds_.load(std::memory_order_relaxed)},
+			{"coalesced", coalesced_.load(std::memory_order_relaxed)},
+			{"timeouts", timeouts_.load(std::memory_order_relaxed)},
+			{"in_flight", in_flight},
+		};
+	}
+
+private:
+	struct flight{
+		std::mutex mutex;
+		bool done{false};
+		Value value{};
+		std::exception_ptr error;
+		std::vector<std::shared_ptr<asio::steady_timer>> waiters;
+	};
+
+	template <typename Fn>
+	void complete(flight& current, const std::string& key, Fn build){
+		Value value{};
+		std::exception_ptr error;
+		try{
+			value = build();
+		} catch(...){
+			error = std::current_exception();
+		}
+
+		// 先移出表，之后到来的请求发起新的构建（通常已经能命中缓存）
+		{
+			std::lock_guard lock(mutex_);
+			flights_.erase(key);
+		}
+
+		std::vector<std::shared_ptr<asio::steady_timer>> waiters;
+		{
+			std::lock_guard lock(current.mutex);
+			current.value = std::move(value);
+			current.error = error;
+			current.done = true;
+			waiters.swap(current.waiters);
+		}
+
+		// 定时器不是线程安全的，在其所属的执行器上取消
+		for(auto& waiter : waiters){
+			asio::post(waiter->get_executor(), [waiter]{ waiter->cancel(); });
+		}
+	}
+
+	asio::any_io_executor build_executor_;
+	std::chrono::steady_clock::duration timeout_;
+
+	mutable std::mutex mutex_;
+	string_hash_map<std::shared_ptr<flight>> flights_;
+
+	std::atomic<std::uint64_t> builds_{0};
+	std::atomic<std::uint64_t> coalesced_{0};
+	std::atomic<std::uint64_t> timeouts_{0};
+};
+} // namespace l2q_http
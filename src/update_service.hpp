@@ -0,0 +1,651 @@
+#pragma once
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <SimpleBase64.h>
+#include <nlohmann/json.hpp>
+#include "chunk_store.h"
+#include "delta_updates.hpp"
+#include "package_stream.h"
+#include "release_catalog.hpp"
+#include "response_cache.hpp"
+#include "response_spill.hpp"
+#include "singleflight.hpp"
+#include "request_process.hpp"
+
+namespace l2q_http{
+/**
+ * @brief 更新服务的业务逻辑（见 readme 中的服务器API）
+ * 所有查询都基于请求开始时取得的发布目录快照
+ */
+class update_service{
+public:
+	using payload_builds = singleflight<response_bytes>;
+
+	// check_versions 一次最多查询的项数
+	static constexpr std::size_t max_batch_size = 256;
+
+	/**
+	 * @param cache 缓存序列化好的 fetch_latest 响应，为 nullptr 时每次流式生成
+	 * @param builds 缓存未命中时合并同一更新包的构建并在其执行器上进行，为 nullptr 时在请求线程上直接构建
+	 * @param deltas 预先生成的增量更新，为 nullptr 时增量接口总是返回完整更新包
+	 * @param chunks 更新包的分块存储，为 nullptr 时分块接口返回 404
+	 * @param spill 缓存的 fetch_latest 响应的磁盘副本，重启后缓存未命中时先从这里映射，为 nullptr 时总是重新生成
+	 */
+	explicit update_service(const release_catalog& catalog, response_cache* cache = nullptr, payload_builds* builds = nullptr,
+	                        const delta_updates* deltas = nullptr, const chunk_store* chunks = nullptr, response_spill* spill = nullptr) noexcept
+		: catalog_(std::addressof(catalog)), cache_(cache), builds_(builds), deltas_(deltas), chunks_(chunks), spill_(spill){}
+
+	/**
+	 * @brief POST /update/check_version
+	 */
+	[[nodiscard]] request_result check_version(request_args&& args) const{
+		return check_version(string_field(args.body, "os-arch"), string_field(args.body, "channel"), string_field(args.body, "version"),
+			args.headers, cache_policy::revalidate);
+	}
+
+	/**
+	 * @brief POST /update/check_versions
+	 * 一次查询多个组件的版本：请求体是 check_version 请求体的数组（可另带 component 字段），
+	 * 按顺序返回每一项的结果，单项的错误写在该项中而不影响其他项。所有项基于同一个快照回答，
+	 * 字段以视图读取、结果直接追加到一个预留好的缓冲区，逐项不分配内存
+	 */
+	[[nodiscard]] request_result check_versions(request_args&& args) const{
+		if(args.method != http_method::post){
+			return method_not_allowed();
+		}
+		if(!args.body.is_array()){
+			return bad_request("expected an array");
+		}
+		if(args.body.size() > max_batch_size){
+			return bad_request(fmt::format("at most {} items per request", max_batch_size));
+		}
+
+		const auto snapshot = catalog_->snapshot();
+		std::string body;
+		body.reserve(16 + args.body.size() * 96);
+		body.append("{\"results\":[");
+		for(const auto& item : args.body){
+			if(body.back() != '[') body.push_back(',');
+			body.push_back('{');
+			// component 只在请求项带有（字符串）时原样返回
+			if(const auto it = item.is_object() ? item.find("component") : item.end(); it != item.end() && it->is_string()){
+				body.append("\"component\":");
+				append_json_string(body, it->get_ref<const std::string&>());
+				body.push_back(',');
+			}
+			if(!item.is_object()){
+				body.append("\"error\":\"invalid item\"}");
+				continue;
+			}
+
+			const auto arch = parse_enum<os_arch>(string_field(item, "os-arch"));
+			const auto version_string = string_field(item, "version");
+			const auto version = pack_version(version_string);
+			if(!arch || !snapshot->has_arch(*arch)){
+				body.append("\"error\":\"unknown arch\"}");
+				continue;
+			}
+			if(!version){
+				body.append("\"error\":\"invalid version\"}");
+				continue;
+			}
+
+			const auto channel = snapshot->resolve_channel(*arch, parse_channel(string_field(item, "channel")));
+			const auto answer = snapshot->check(*arch, channel, *version);
+			body.append("\"version\":");
+			append_json_string(body, answer.latest ? std::string_view{answer.latest->version_string} : version_string);
+			fmt::format_to(std::back_inserter(body), ",\"flags\":{}}}", answer.flags);
+		}
+		body.append("]}");
+
+		return request_result{.body = std::move(body)};
+	}
+
+	/**
+	 * @brief GET /update/check/{os-arch}/{channel}/{version}
+	 * 与 POST 版本返回相同的 JSON，但只由 URL 决定，可以被 CDN 与反向代理缓存
+	 */
+	[[nodiscard]] request_result check_version_get(request_args&& args) const{
+		if(args.method != http_method::get){
+			return method_not_allowed();
+		}
+		return check_version(path_param(args, "os-arch"), path_param(args, "channel"), path_param(args, "version"),
+			args.headers, cache_policy::shared);
+	}
+
+	/**
+	 * @brief POST /update/fetch_latest
+	 */
+	[[nodiscard]] request_result fetch_latest(request_args&& args) const{
+		return fetch_latest(string_field(args.body, "os-arch"), string_field(args.body, "channel"), args.headers, cache_policy::revalidate);
+	}
+
+	/**
+	 * @brief GET /update/latest/{os-arch}/{channel}
+	 * 与 POST 版本返回相同的 JSON，但只由 URL 决定，可以被 CDN 与反向代理缓存
+	 */
+	[[nodiscard]] request_result fetch_latest_get(request_args&& args) const{
+		if(args.method != http_method::get){
+			return method_not_allowed();
+		}
+		return fetch_latest(path_param(args, "os-arch"), path_param(args, "channel"), args.headers, cache_policy::shared);
+	}
+
+	/**
+	 * @brief GET /update/package/{os-arch}/{channel}
+	 * 以二进制直接发送存储中的压缩对象，省去 Base64 带来的 33% 膨胀和客户端的 JSON 解析；
+	 * 校验码放在 X-Package-Hash 响应头中
+	 */
+	[[nodiscard]] request_result download_package(request_args&& args) const{
+		if(args.method != http_method::get){
+			return method_not_allowed();
+		}
+
+		request_result error;
+		const auto package = locate_package(path_param(args, "os-arch"), path_param(args, "channel"), error);
+		if(!package){
+			return error;
+		}
+		return revalidate(args, package_download(*package));
+	}
+
+	/**
+	 * @brief GET /update/delta/{os-arch}/{channel}/{version}
+	 * 客户端版本有比完整更新包小的差分时发送差分（X-Update-Kind: delta，X-Delta-Base 为应用差分所需的旧版本校验码），
+	 * 否则与 download_package 相同地发送完整更新包（X-Update-Kind: full）
+	 */
+	[[nodiscard]] request_result download_delta(request_args&& args) const{
+		if(args.method != http_method::get){
+			return method_not_allowed();
+		}
+
+		request_result error;
+		const auto package = locate_package(path_param(args, "os-arch"), path_param(args, "channel"), error);
+		if(!package){
+			return error;
+		}
+
+		const auto version = pack_version(path_param(args, "version"));
+		if(!version){
+			return bad_request("invalid version");
+		}
+
+		if(const auto base = locate_release(path_param(args, "os-arch"), path_param(args, "channel"), *version); base && deltas_){
+			if(const auto delta = deltas_->find(base->sha256, package->sha256)){
+				return revalidate(args, request_result{
+					.file = delta->object,
+					.content_type = "application/octet-stream",
+					.headers = {
+						{"Content-Encoding", "gzip"},
+						{"X-Update-Kind", "delta"},
+						{"X-Delta-Base", base->hash()},
+						{"X-Package-Hash", package->hash()},
+					},
+					.etag = fmt::format("\"{}-{}\"", delta->base, delta->target),
+					.cache_control = std::string{cache_control(cache_policy::shared)},
+				});
+			}
+		}
+
+		auto full = package_download(*package);
+		full.headers.emplace_back("X-Update-Kind", "full");
+		return revalidate(args, std::move(full));
+	}
+
+	/**
+	 * @brief GET /update/chunks/{os-arch}/{channel}
+	 * 最新更新包的块列表，客户端只需通过 download_chunk 下载本地没有的块，按顺序拼接后即为更新包原始数据
+	 */
+	[[nodiscard]] request_result chunk_list(request_args&& args) const{
+		if(args.method != http_method::get){
+			return method_not_allowed();
+		}
+
+		request_result error;
+		const auto package = locate_package(path_param(args, "os-arch"), path_param(args, "channel"), error);
+		if(!package){
+			return error;
+		}
+
+		const auto manifest = chunks_ ? chunks_->manifest(package->sha256) : nullptr;
+		if(!manifest){
+			return request_result{{{"reason", "chunks not available"}}, status_code::not_found};
+		}
+
+		auto etag = fmt::format("\"{}-chunks\"", package->sha256);
+		if(not_modified(args, etag)){
+			return request_result{
+				.code = status_code::not_modified,
+				.etag = std::move(etag),
+				.cache_control = std::string{cache_control(cache_policy::shared)},
+			};
+		}
+
+		auto chunks = nlohmann::json::array();
+		for(const auto& chunk : manifest->chunks){
+			chunks.push_back({{"hash", "sha256:" + chunk.sha256}, {"size", chunk.size}});
+		}
+		return request_result{
+			.data = {
+				{"hash", package->hash()},
+				{"size", manifest->size},
+				{"chunks", std::move(chunks)},
+			},
+			.etag = std::move(etag),
+			.cache_control = std::string{cache_control(cache_policy::shared)},
+		};
+	}
+
+	/**
+	 * @brief GET /update/chunk/{sha256}
+	 * 块按内容寻址，内容永远不变，允许客户端与 CDN 长期缓存
+	 */
+	[[nodiscard]] request_result download_chunk(request_args&& args) const{
+		if(args.method != http_method::get){
+			return method_not_allowed();
+		}
+
+		const auto digest = path_param(args, "sha256");
+		const auto object = chunks_ ? chunks_->chunk_object(digest) : std::nullopt;
+		if(!object){
+			return request_result{{{"reason", "chunk not found"}}, status_code::not_found};
+		}
+		return revalidate(args, request_result{
+			.file = *object,
+			.content_type = "application/octet-stream",
+			.headers = {{"Content-Encoding", "gzip"}},
+			.etag = fmt::format("\"{}\"", digest),
+			.cache_control = "public, max-age=31536000, immutable",
+		});
+	}
+
+	/**
+	 * @brief 为快照中每个频道的最新更新包生成 fetch_latest 响应并放入缓存，同时写入 spill，在快照发布之前于后台线程调用，
+	 * 发布后的第一批请求直接命中缓存；spill 中已有的响应不生成，第一次请求时再映射
+	 * @return 新生成的响应数
+	 * @throw std::runtime_error 读取更新包对象失败
+	 */
+	std::size_t prepare(const catalog_snapshot& snapshot) const{
+		if(!cache_){
+			return 0;
+		}
+
+		std::size_t prepared = 0;
+		snapshot.for_each_latest([&](const package_info& package){
+			const auto suffix = latest_suffix(package);
+			if(latest_body_size(package, suffix) > cache_->max_entry_size()){
+				return;
+			}
+			const auto etag = latest_etag(package);
+			for(std::size_t p = 0; p < cache_policy_count; ++p){
+				const auto policy = static_cast<cache_policy>(p);
+				auto key = latest_key(package, policy);
+				if(cache_->contains(key) || (spill_ && spill_->contains(key))) continue;
+				auto response = make_response_bytes(serialize_latest(package, suffix, etag, policy));
+				if(spill_){
+					spill_->save(key, *response);
+				}
+				cache_->insert(std::move(key), std::move(response));
+				++prepared;
+			}
+		});
+		return prepared;
+	}
+
+	/**
+	 * @brief 发布新快照后淘汰不再被任何频道引用的更新包的缓存响应
+	 * @return 淘汰的条目数
+	 */
+	std::size_t evict_stale(const catalog_snapshot& snapshot) const{
+		if(!cache_){
+			return 0;
+		}
+
+		string_hash_set<> live;
+		snapshot.for_each_latest([&](const package_info& package){
+			for(std::size_t p = 0; p < cache_policy_count; ++p){
+				live.insert(latest_key(package, static_cast<cache_policy>(p)));
+			}
+		});
+		if(spill_){
+			spill_->retain_if("latest/", [&](const std::string_view key){
+				return live.contains(key);
+			});
+		}
+		return cache_->retain_if([&](const std::string_view key){
+			return live.contains(key);
+		});
+	}
+
+	/**
+	 * @brief 把缓存中还没有磁盘副本的 fetch_latest 响应写入 spill，在关闭服务时调用
+	 * @return 写入的响应数
+	 */
+	std::size_t spill() const{
+		if(!cache_ || !spill_){
+			return 0;
+		}
+
+		std::size_t saved = 0;
+		for(const auto& [key, response] : cache_->entries()){
+			if(key.starts_with("latest/") && spill_->save(key, *response)){
+				++saved;
+			}
+		}
+		return saved;
+	}
+
+private:
+	/**
+	 * @brief check_version 的 POST 与 GET 路由共用的实现
+	 */
+	request_result check_version(const std::string_view os_arch_name, const std::string_view channel_name, const std::string_view version_string,
+	                             const string_hash_map<std::string>& headers, const cache_policy policy) const{
+		const auto snapshot = catalog_->snapshot();
+
+		const auto arch = parse_enum<os_arch>(os_arch_name);
+		if(!arch || !snapshot->has_arch(*arch)){
+			return bad_request("unknown arch");
+		}
+
+		const auto version = pack_version(version_string);
+		if(!version){
+			return bad_request("invalid version");
+		}
+
+		const auto channel = snapshot->resolve_channel(*arch, parse_channel(channel_name));
+		const auto p = static_cast<std::size_t>(policy);
+
+		// 快速路径：已知版本直接发送预先生成的响应字节；If-None-Match 匹配时发送预先生成的 304。
+		// 协商了字典压缩的客户端需要经过会话的编码处理（200 与 304 都带弱标签），走计算路径
+		const auto* precomputed = snapshot->precomputed(*arch, channel, *version);
+		if(precomputed && !headers.contains(std::string_view{"x-l2q-dictionary"})){
+			// 别名构造：响应字节的生命周期跟随快照
+			const auto* if_none_match = headers.try_find("if-none-match");
+			if(if_none_match && etag_matches(*if_none_match, precomputed->etag)){
+				return request_result{.raw = response_bytes(snapshot, &precomputed->not_modified[p])};
+			}
+			return request_result{.raw = response_bytes(snapshot, &precomputed->ok[p])};
+		}
+
+		return request_result{
+			.data = version_answer_json(snapshot->check(*arch, channel, *version), version_string),
+			.etag = snapshot->version_etag(*arch, channel, *version),
+			.cache_control = std::string{cache_control(policy)},
+		};
+	}
+
+	/**
+	 * @brief fetch_latest 的 POST 与 GET 路由共用的实现
+	 * 同一个更新包的响应字节完全相同：能放进缓存的响应整体序列化一次后由所有会话共享；
+	 * 否则在发送时流式完成 读取 -> Base64 -> JSON 包装，不在内存中保留完整副本
+	 */
+	request_result fetch_latest(const std::string_view os_arch_name, const std::string_view channel_name,
+	                            const string_hash_map<std::string>& headers, const cache_policy policy) const{
+		request_result error;
+		const auto package = locate_package(os_arch_name, channel_name, error);
+		if(!package){
+			return error;
+		}
+
+		auto etag = latest_etag(*package);
+		const auto* if_none_match = headers.try_find("if-none-match");
+		if(if_none_match && etag_matches(*if_none_match, etag)){
+			return request_result{.raw = make_response_bytes(serialize_not_modified(etag, cache_control(policy)))};
+		}
+
+		const auto suffix = latest_suffix(*package);
+		if(cache_ && latest_body_size(*package, suffix) <= cache_->max_entry_size()){
+			auto key = latest_key(*package, policy);
+			if(auto cached = cache_->find(key)){
+				return request_result{.raw = std::move(cached)};
+			}
+
+			if(builds_){
+				return request_result{
+					.deferred = [this, key = std::move(key), package = *package, suffix, etag = std::move(etag), policy]{
+						return build_latest(key, package, suffix, etag, policy);
+					},
+				};
+			}
+
+			auto response = load_or_build(key, *package, suffix, etag, policy);
+			cache_->insert(std::move(key), response);
+			return request_result{.raw = std::move(response)};
+		}
+
+		// 流在第一次读取时才打开
+		auto stream = [object = package->object, suffix, stream = std::shared_ptr<gzip_base64_stream>{}]() mutable{
+			if(!stream){
+				stream = std::make_shared<gzip_base64_stream>(gzip_base64_stream::precompressed(object, std::string{latest_prefix}, suffix));
+			}
+			return stream->next();
+		};
+		return request_result{
+			.stream = std::move(stream),
+			.etag = std::move(etag),
+			.cache_control = std::string{cache_control(policy)},
+		};
+	}
+
+	/**
+	 * @brief 缓存未命中时构建 fetch_latest 响应，同一个键的并发请求只构建一次，其余等待同一份结果
+	 * 构建超时返回 503，构建失败返回 500
+	 */
+	asio::awaitable<response_bytes> build_latest(std::string key, package_info package, std::string suffix, std::string etag, const cache_policy policy) const{
+		// 构建函数先存为局部变量：GCC 12 会重复析构 co_await 表达式中的 lambda 临时对象
+		auto build = [this, key, package = std::move(package), suffix = std::move(suffix), etag = std::move(etag), policy]{
+			auto response = load_or_build(key, package, suffix, etag, policy);
+			cache_->insert(key, response);
+			return response;
+		};
+		try{
+			auto response = co_await builds_->run(key, std::move(build));
+			co_return response;
+		} catch(const std::system_error& e){
+			if(e.code() != asio::error::timed_out){
+				spdlog::error("building {} failed: {}", key, e.what());
+				co_return make_response_bytes(error_response(status_code::internal_server_error, e.what()));
+			}
+			spdlog::warn("building {} timed out", key);
+			co_return make_response_bytes(error_response(status_code::service_unavailable, "package build timed out", "Retry-After: 1\r\n"));
+		} catch(const std::exception& e){
+			spdlog::error("building {} failed: {}", key, e.what());
+			co_return make_response_bytes(error_response(status_code::internal_server_error, e.what()));
+		}
+	}
+
+	/**
+	 * @brief 先从 spill 映射之前保存的响应（重启之后），没有时重新生成
+	 */
+	response_bytes load_or_build(const std::string_view key, const package_info& package, const std::string_view suffix, const std::string_view etag, const cache_policy policy) const{
+		if(spill_){
+			if(auto spilled = spill_->load(key)){
+				return spilled;
+			}
+		}
+		return make_response_bytes(serialize_latest(package, suffix, etag, policy));
+	}
+
+	static std::string error_response(const status_code code, const std::string_view reason, const std::string_view extra_headers = {}){
+		return serialize_response(code, "application/json", extra_headers, nlohmann::json{{"reason", reason}}.dump());
+	}
+
+	static constexpr std::string_view latest_prefix = R"({"data":")";
+
+	static std::string latest_suffix(const package_info& package){
+		return R"(","hash":")" + package.hash() + R"("})";
+	}
+
+	static std::string latest_etag(const package_info& package){
+		return fmt::format("\"{}-json\"", package.sha256);
+	}
+
+	/**
+	 * @brief fetch_latest 响应的缓存键
+	 * 键只由内容决定，即使在发布新目录的同时插入旧快照的条目也不会返回错误的数据
+	 */
+	static std::string latest_key(const package_info& package, const cache_policy policy){
+		return fmt::format("latest/{}/{}", package.sha256, static_cast<int>(policy));
+	}
+
+	static std::size_t latest_body_size(const package_info& package, const std::string_view suffix) noexcept{
+		return latest_prefix.size() + SimpleBase64::encoded_size(package.compressed_size) + suffix.size();
+	}
+
+	/**
+	 * @brief 一次性序列化完整的 fetch_latest 响应，Base64 直接编码到响应字符串中
+	 */
+	static std::string serialize_latest(const package_info& package, const std::string_view suffix, const std::string_view etag, const cache_policy policy){
+		std::string compressed(package.compressed_size, '\0');
+		std::ifstream in(package.object, std::ios::binary);
+		in.read(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+		if(!in){
+			throw std::runtime_error("failed to read package object " + package.object.string());
+		}
+
+		const auto body_size = latest_body_size(package, suffix);
+		auto response = serialize_response_head(status_code::ok, "application/json",
+			fmt::format("ETag: {}\r\nCache-Control: {}\r\n", etag, cache_control(policy)), body_size);
+		const auto head_size = response.size();
+
+		response.resize(head_size + body_size);
+		auto* out = response.data() + head_size;
+		out = std::copy(latest_prefix.begin(), latest_prefix.end(), out);
+		out += SimpleBase64::encode_into(reinterpret_cast<const unsigned char*>(compressed.data()), compressed.size(), out);
+		std::copy(suffix.begin(), suffix.end(), out);
+		return response;
+	}
+
+	/**
+	 * @brief 根据 os-arch 与 channel 找到最新版本的更新包对象，找不到时填充 error 并返回 std::nullopt
+	 * 未知的 channel 回退到 stable
+	 */
+	std::optional<package_info> locate_package(const std::string_view os_arch_name, const std::string_view channel, request_result& error) const{
+		const auto snapshot = catalog_->snapshot();
+
+		const auto arch = parse_enum<os_arch>(os_arch_name);
+		if(!arch || !snapshot->has_arch(*arch)){
+			error = bad_request("unknown arch");
+			return std::nullopt;
+		}
+
+		const auto* latest = snapshot->track(*arch, snapshot->resolve_channel(*arch, parse_channel(channel))).latest();
+		if(!latest || !latest->stored){
+			error = request_result{{{"reason", "no package available"}}, status_code::not_found};
+			return std::nullopt;
+		}
+		return latest->stored;
+	}
+
+	/**
+	 * @brief 查找 (os-arch, channel) 中与客户端版本完全相同的发布的更新包对象
+	 */
+	std::optional<package_info> locate_release(const std::string_view os_arch_name, const std::string_view channel, const packed_version version) const{
+		const auto snapshot = catalog_->snapshot();
+		const auto arch = parse_enum<os_arch>(os_arch_name);
+		if(!arch){
+			return std::nullopt;
+		}
+
+		const auto& track = snapshot->track(*arch, snapshot->resolve_channel(*arch, parse_channel(channel)));
+		const auto it = std::ranges::lower_bound(track.versions, version);
+		if(it == track.versions.end() || *it != version){
+			return std::nullopt;
+		}
+		return track.releases[static_cast<std::size_t>(it - track.versions.begin())].stored;
+	}
+
+	static request_result package_download(const package_info& package){
+		return request_result{
+			.file = package.object,
+			.content_type = "application/octet-stream",
+			.headers = {
+				{"Content-Encoding", "gzip"},
+				{"X-Package-Hash", package.hash()},
+			},
+			// 对象按内容寻址，摘要即是强实体标签
+			.etag = fmt::format("\"{}\"", package.sha256),
+			.cache_control = std::string{cache_control(cache_policy::shared)},
+		};
+	}
+
+	/**
+	 * @brief 请求的 If-None-Match 与 etag 匹配
+	 */
+	static bool not_modified(const request_args& args, const std::string_view etag){
+		const auto* if_none_match = args.headers.try_find("if-none-match");
+		return if_none_match && etag_matches(*if_none_match, etag);
+	}
+
+	/**
+	 * @brief 验证器匹配时把响应标记为 304：会话据此直接发送 304，不再打开文件或生成响应体
+	 */
+	static request_result revalidate(const request_args& args, request_result&& response){
+		if(not_modified(args, response.etag)){
+			response.code = status_code::not_modified;
+		}
+		return std::move(response);
+	}
+
+	static request_result bad_request(const std::string_view reason){
+		return request_result{{{"reason", reason}}, status_code::bad_request};
+	}
+
+	static request_result method_not_allowed(){
+		return request_result{{{"reason", "method not allowed"}}, status_code::method_not_allowed};
+	}
+
+	static std::string path_param(const request_args& args, const std::string_view name){
+		if(const auto* value = args.params.try_find(name)){
+			return *value;
+		}
+		return {};
+	}
+
+	// 返回的视图指向 body 中的字符串，不分配内存
+	static std::string_view string_field(const nlohmann::json& body, const char* key){
+		if(body.is_object()){
+			if(const auto it = body.find(key); it != body.end() && it->is_string()){
+				return it->get_ref<const std::string&>();
+			}
+		}
+		return {};
+	}
+
+	/**
+	 * @brief 以 JSON 字符串的形式（含引号）追加到 out
+	 */
+	static void append_json_string(std::string& out, const std::string_view value){
+		out.push_back('"');
+		for(const char c : value){
+			switch(c){
+				case '"': out.append("\\\""); break;
+				case '\\': out.append("\\\\"); break;
+				case '\n': out.append("\\n"); break;
+				case '\r': out.append("\\r"); break;
+				case '\t': out.append("\\t"); break;
+				default:
+					if(static_cast<unsigned char>(c) < 0x20){
+						fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned char>(c));
+					} else{
+						out.push_back(c);
+					}
+			}
+		}
+		out.push_back('"');
+	}
+
+	const release_catalog* catalog_;
+	response_cache* cache_;
+	payload_builds* builds_;
+	const delta_updates* deltas_;
+	const chunk_store* chunks_;
+	response_spill* spill_;
+};
+} // namespace l2q_http
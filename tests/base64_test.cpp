@@ -0,0 +1,116 @@
+#include <SimpleBase64.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.hpp"
+
+namespace {
+    using SimpleBase64::decode_mode;
+    using SimpleBase64::detail::isa;
+
+    constexpr isa all_isas[] = {isa::scalar, isa::ssse3, isa::avx2};
+
+    const char* isa_name(isa which) {
+        return which == isa::avx2 ? "avx2" : which == isa::ssse3 ? "ssse3" : "scalar";
+    }
+
+    std::string encode_with(const std::vector<std::uint8_t>& data, isa which) {
+        std::string out(SimpleBase64::encoded_size(data.size()), '\0');
+        out.resize(SimpleBase64::detail::encode(data.data(), data.size(), out.data(), which));
+        return out;
+    }
+
+    std::optional<std::vector<std::uint8_t>> decode_with(std::string_view str, decode_mode mode, isa which) {
+        std::vector<std::uint8_t> out(SimpleBase64::decoded_size(str.size()));
+        const auto size = SimpleBase64::detail::decode(str, out.data(), mode, which);
+        if (!size) return std::nullopt;
+        out.resize(*size);
+        return out;
+    }
+
+    // 覆盖 SIMD 主循环的各个边界：16/12 字节（SSSE3）、28/24 字节（AVX2）及其余数
+    void round_trip(std::mt19937& rng) {
+        for (std::size_t len = 0; len <= 300; ++len) {
+            std::vector<std::uint8_t> data(len);
+            for (auto& b : data) b = static_cast<std::uint8_t>(rng());
+
+            const auto reference = encode_with(data, isa::scalar);
+            L2Q_CHECK(reference.size() == SimpleBase64::encoded_size(len));
+            for (const auto which : all_isas) {
+                if (!SimpleBase64::detail::isa_supported(which)) continue;
+                L2Q_CHECK(encode_with(data, which) == reference);
+                L2Q_CHECK(decode_with(reference, decode_mode::strict, which) == data);
+                L2Q_CHECK(decode_with(reference, decode_mode::lenient, which) == data);
+            }
+            L2Q_CHECK(SimpleBase64::encode(data) == reference);
+            L2Q_CHECK(SimpleBase64::decode_strict(reference) == data);
+        }
+    }
+
+    // 在任意位置放入非法字符：严格模式各实现都拒绝，宽松模式与逐字符的参考实现一致
+    void invalid_characters(std::mt19937& rng) {
+        for (std::size_t len = 3; len <= 150; len += 3) {
+            std::vector<std::uint8_t> data(len);
+            for (auto& b : data) b = static_cast<std::uint8_t>(rng());
+            const auto encoded = encode_with(data, isa::scalar);
+
+            for (std::size_t pos = 0; pos < encoded.size(); ++pos) {
+                for (const char bad : {'!', '-', '_', '\n', '\x80', '\xff', '\0'}) {
+                    auto corrupted = encoded;
+                    corrupted[pos] = bad;
+
+                    std::vector<std::uint8_t> expected(SimpleBase64::decoded_size(corrupted.size()));
+                    expected.resize(SimpleBase64::detail::decode_lenient(corrupted, expected.data()));
+                    for (const auto which : all_isas) {
+                        if (!SimpleBase64::detail::isa_supported(which)) continue;
+                        L2Q_CHECK(!decode_with(corrupted, decode_mode::strict, which));
+                        L2Q_CHECK(decode_with(corrupted, decode_mode::lenient, which) == expected);
+                    }
+                }
+            }
+        }
+    }
+
+    void padding() {
+        for (const auto which : all_isas) {
+            if (!SimpleBase64::detail::isa_supported(which)) continue;
+            const auto strict = [which](std::string_view s) { return decode_with(s, decode_mode::strict, which); };
+            const auto bytes = [](std::string_view s) { return std::vector<std::uint8_t>(s.begin(), s.end()); };
+
+            L2Q_CHECK(strict("") == std::vector<std::uint8_t>{});
+            L2Q_CHECK(strict("Zg==") == bytes("f"));
+            L2Q_CHECK(strict("Zm8=") == bytes("fo"));
+            L2Q_CHECK(strict("Zm9v") == bytes("foo"));
+            // 长度不是 4 的倍数、填充不在末尾、填充过多、填充前的比特不为 0
+            L2Q_CHECK(!strict("Zm9"));
+            L2Q_CHECK(!strict("Zg=="
+                              "Zm9v"));
+            L2Q_CHECK(!strict("Z==="));
+            L2Q_CHECK(!strict("Zh=="));
+            L2Q_CHECK(!strict("Zm9="));
+
+            // 宽松模式：跳过非法字符，遇到 '=' 停止
+            L2Q_CHECK(decode_with("Zm9v\nYmFy", decode_mode::lenient, which) == bytes("foobar"));
+            L2Q_CHECK(decode_with("Zg==Zm9v", decode_mode::lenient, which) == bytes("f"));
+            L2Q_CHECK(decode_with("Zm9", decode_mode::lenient, which) == bytes("fo"));
+        }
+    }
+} // namespace
+
+int main() {
+    std::mt19937 rng(20240601);
+    round_trip(rng);
+    invalid_characters(rng);
+    padding();
+
+    for (const auto which : all_isas) {
+        std::printf("%s: %s\n", isa_name(which), SimpleBase64::detail::isa_supported(which) ? "checked" : "unsupported, skipped");
+    }
+    return 0;
+}
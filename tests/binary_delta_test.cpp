@@ -0,0 +1,133 @@
+#include "src/binary_delta.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "check.hpp"
+
+namespace {
+    using l2q_http::apply_delta;
+    using l2q_http::delta_options;
+    using l2q_http::make_delta;
+
+    std::string random_bytes(std::mt19937& rng, std::size_t size) {
+        std::string out(size, '\0');
+        for (auto& c : out) c = static_cast<char>(rng());
+        return out;
+    }
+
+    // 模拟新版本：少量字节修改、插入与删除
+    std::string mutate(std::mt19937& rng, std::string data) {
+        for (int i = 0; i < 20 && !data.empty(); ++i) {
+            const auto pos = rng() % data.size();
+            switch (rng() % 3) {
+                case 0: data[pos] = static_cast<char>(data[pos] + 1); break;
+                case 1: data.insert(pos, random_bytes(rng, rng() % 64)); break;
+                default: data.erase(pos, rng() % 64); break;
+            }
+        }
+        return data;
+    }
+
+    // 差分未压缩：匹配部分的 diff 字节为 0（压缩后几乎不占空间），与 base 无关的数据原样进入 extra
+    bool mostly_matched(std::string_view delta, std::string_view target) {
+        return static_cast<std::size_t>(std::count(delta.begin(), delta.end(), '\0')) > target.size() * 9 / 10;
+    }
+
+    void round_trip(std::string_view base, std::string_view target, const delta_options& options = {}) {
+        const auto delta = make_delta(base, target, options);
+        const auto rebuilt = apply_delta(base, delta);
+        L2Q_CHECK(rebuilt);
+        L2Q_CHECK(*rebuilt == target);
+    }
+
+    void put_u64_at(std::string& delta, std::size_t offset, std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) delta[offset + i] = static_cast<char>(value >> (8 * i));
+    }
+
+    void edge_sizes(std::mt19937& rng) {
+        const auto data = random_bytes(rng, 1000);
+        round_trip("", "");
+        round_trip("", data);
+        round_trip(data, "");
+        round_trip("x", "");
+        round_trip("x", "x");
+        round_trip("x", "y");
+        round_trip("x", data);
+        round_trip(data, "x");
+    }
+
+    void single_block(std::mt19937& rng) {
+        // 目标小于 min_block_size 时只有一个块，即使允许多个线程
+        const auto base = random_bytes(rng, 20000);
+        const auto target = mutate(rng, base);
+        round_trip(base, target, {.threads = 4});
+        round_trip(base, target, {.threads = 1, .min_block_size = 1});
+
+        L2Q_CHECK(mostly_matched(make_delta(base, target, {.threads = 4}), target));
+    }
+
+    void multi_block(std::mt19937& rng) {
+        const auto base = random_bytes(rng, 256 * 1024);
+        const auto target = mutate(rng, base);
+        for (const std::size_t threads : {2, 3, 4, 7}) {
+            round_trip(base, target, {.threads = threads, .min_block_size = 4096});
+        }
+        // 块边界处的匹配被截断，但相似数据的大部分仍应找到匹配
+        L2Q_CHECK(mostly_matched(make_delta(base, target, {.threads = 4, .min_block_size = 4096}), target));
+
+        // 块数多于目标字节数时每块至少一个字节
+        round_trip(base, "abc", {.threads = 8, .min_block_size = 1});
+        // 与 base 无关的目标
+        round_trip(base, random_bytes(rng, 64 * 1024), {.threads = 4, .min_block_size = 4096});
+    }
+
+    void rejects_invalid(std::mt19937& rng) {
+        const auto base = random_bytes(rng, 4096);
+        const auto target = mutate(rng, base);
+        const auto delta = make_delta(base, target);
+        L2Q_CHECK(apply_delta(base, delta) == target);
+
+        // 任意位置截断
+        for (std::size_t size = 0; size < delta.size(); ++size) {
+            L2Q_CHECK(!apply_delta(base, std::string_view{delta}.substr(0, size)));
+        }
+        // 多余的尾部数据
+        L2Q_CHECK(!apply_delta(base, delta + '\0'));
+        // base 不符：大小不同
+        L2Q_CHECK(!apply_delta(std::string_view{base}.substr(1), delta));
+
+        constexpr std::size_t header = 8 + 8 + 8;
+        constexpr std::size_t record = header; // 第一条记录紧随头部：diff 长度、extra 长度、base 偏移
+        const auto corrupt = [&](std::size_t offset, std::uint64_t value) {
+            auto bad = delta;
+            put_u64_at(bad, offset, value);
+            return apply_delta(base, bad);
+        };
+        {
+            auto bad = delta;
+            bad[0] = 'X';
+            L2Q_CHECK(!apply_delta(base, bad));
+        }
+        L2Q_CHECK(!corrupt(8, base.size() + 1));                 // base 大小
+        L2Q_CHECK(!corrupt(16, delta.size()));                   // target 大小超过差分能产生的数据
+        L2Q_CHECK(!corrupt(16, target.size() - 1));              // target 大小与记录不符
+        L2Q_CHECK(!corrupt(record, UINT64_MAX));                 // diff 长度溢出
+        L2Q_CHECK(!corrupt(record + 8, UINT64_MAX));             // extra 长度溢出
+        L2Q_CHECK(!corrupt(record + 16, base.size() + 1));       // 偏移越界
+        L2Q_CHECK(!corrupt(record + 16, UINT64_MAX));
+        L2Q_CHECK(!corrupt(record + 16, base.size()));           // 偏移 + diff 长度越界
+    }
+} // namespace
+
+int main() {
+    std::mt19937 rng(20240601);
+    edge_sizes(rng);
+    single_block(rng);
+    multi_block(rng);
+    rejects_invalid(rng);
+    return 0;
+}
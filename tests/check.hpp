@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+// 与 assert 不同，NDEBUG 下同样生效
+#define L2Q_CHECK(expr)                                                                   \
+    do {                                                                                  \
+        if (!(expr)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            std::exit(1);                                                                 \
+        }                                                                                 \
+    } while (false)
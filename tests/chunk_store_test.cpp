@@ -0,0 +1,103 @@
+#include "src/chunk_store.h"
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.hpp"
+#include "src/sha256.h"
+
+namespace {
+    using l2q_http::chunking_params;
+
+    std::string random_bytes(std::mt19937& rng, std::size_t size) {
+        std::string out(size, '\0');
+        for (auto& c : out) c = static_cast<char>(rng());
+        return out;
+    }
+
+    struct chunk {
+        std::size_t offset;
+        std::string digest;
+    };
+
+    // 与 chunk_store::add 相同的切分方式，同时检查除最后一块外的块大小都在 [min_size, max_size] 内
+    std::vector<chunk> chunk_digests(std::string_view data, const chunking_params& params) {
+        std::vector<chunk> chunks;
+        std::size_t offset = 0;
+        while (!data.empty()) {
+            const auto size = l2q_http::find_chunk_boundary(data, params);
+            L2Q_CHECK(size != 0 && size <= data.size());
+            if (size != data.size()) {
+                L2Q_CHECK(size >= params.min_size && size <= params.max_size);
+            }
+            chunks.push_back({offset, sha256::to_hex(sha256::hash(data.substr(0, size)))});
+            data.remove_prefix(size);
+            offset += size;
+        }
+        return chunks;
+    }
+
+    // 修改 [begin, end) 之后，原先从 end 之后开始的块除最前面两个外都应原样出现在新结果的末尾：
+    // 每块开头的 min_size 字节不检查边界，删除的字节可能让紧随其后的一个原边界落入这段区域而被跳过
+    bool resynchronized(const std::vector<chunk>& original, const std::vector<chunk>& edited, std::size_t end) {
+        std::size_t after = 0;
+        while (after < original.size() && original[original.size() - 1 - after].offset >= end) {
+            ++after;
+        }
+        std::size_t common = 0;
+        while (common < original.size() && common < edited.size()
+               && original[original.size() - 1 - common].digest == edited[edited.size() - 1 - common].digest) {
+            ++common;
+        }
+        return after <= common + 2;
+    }
+
+    // 在开头附近插入或删除字节后只有附近的块改变，之后的块摘要不变
+    void edits_near_start(std::mt19937& rng, const chunking_params& params, std::size_t size) {
+        const auto data = random_bytes(rng, size);
+        const auto original = chunk_digests(data, params);
+        L2Q_CHECK(original.size() > 16);
+
+        for (const std::size_t offset : {std::size_t{0}, std::size_t{1}, params.min_size / 2, params.min_size + 7}) {
+            for (const std::size_t length : {1, 3, 64, 1000}) {
+                auto inserted = data;
+                inserted.insert(offset, random_bytes(rng, length));
+                L2Q_CHECK(resynchronized(original, chunk_digests(inserted, params), offset));
+
+                auto erased = data;
+                erased.erase(offset, length);
+                L2Q_CHECK(resynchronized(original, chunk_digests(erased, params), offset + length));
+            }
+        }
+    }
+
+    // 没有内容边界的数据（全 0）在 max_size 处强制切分
+    void low_entropy(const chunking_params& params) {
+        const std::string zeros(params.max_size * 5 + 17, '\0');
+        const auto digests = chunk_digests(zeros, params);
+        L2Q_CHECK(digests.size() >= 6);
+    }
+
+    void short_inputs(const chunking_params& params) {
+        L2Q_CHECK(l2q_http::find_chunk_boundary({}, params) == 0);
+        const std::string small(params.min_size, 'x');
+        L2Q_CHECK(l2q_http::find_chunk_boundary(small, params) == small.size());
+    }
+} // namespace
+
+int main() {
+    std::mt19937 rng(20240601);
+
+    const chunking_params defaults;
+    const chunking_params small{.min_size = 256, .average_size = 1024, .max_size = 4096};
+
+    edits_near_start(rng, defaults, 8 * 1024 * 1024);
+    edits_near_start(rng, small, 256 * 1024);
+    for (const auto& params : {defaults, small}) {
+        low_entropy(params);
+        short_inputs(params);
+    }
+    return 0;
+}
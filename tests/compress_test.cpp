@@ -0,0 +1,70 @@
+#include "src/compress.h"
+
+#include <limits>
+#include <random>
+#include <string>
+
+#include "check.hpp"
+
+namespace {
+    std::string random_text(std::mt19937& rng, std::size_t size) {
+        std::string out(size, '\0');
+        for (auto& c : out) c = static_cast<char>('a' + rng() % 26);
+        return out;
+    }
+
+    void round_trip(std::mt19937& rng) {
+        for (const std::size_t size : {0, 1, 100, 64 * 1024, 1024 * 1024}) {
+            const auto data = random_text(rng, size);
+            const auto gzip = gzip_compress(data);
+            L2Q_CHECK(gzip);
+            L2Q_CHECK(gzip->capacity() - gzip->size() < 64);
+            L2Q_CHECK(gzip_decompress(*gzip) == data);
+
+            const auto deflate = deflate_compress(data, "abcdefghijklmnopqrstuvwxyz");
+            L2Q_CHECK(deflate);
+            L2Q_CHECK(deflate->capacity() - deflate->size() < 64);
+            std::string out;
+            L2Q_CHECK(deflate_decompress(*deflate, "abcdefghijklmnopqrstuvwxyz", {}, out) == inflate_status::ok);
+            L2Q_CHECK(out == data);
+            L2Q_CHECK(deflate_decompress(*deflate, "other dictionary", {}, out) == inflate_status::invalid_data || data.empty());
+        }
+    }
+
+    // 不带 limits 的重载使用默认上限（64 MiB、256:1），超过时返回 std::nullopt
+    void default_limits() {
+        const std::string zeros(4 * 1024 * 1024, '\0');
+        const auto bomb = gzip_compress(zeros, 9);
+        L2Q_CHECK(bomb);
+        L2Q_CHECK(zeros.size() / bomb->size() > 256);
+        L2Q_CHECK(!gzip_decompress(*bomb));
+
+        std::string out;
+        L2Q_CHECK(gzip_decompress(*bomb, {}, out) == inflate_status::ratio_limit_exceeded);
+        L2Q_CHECK(gzip_decompress(*bomb, {.max_output_size = zeros.size() - 1, .max_ratio = 0}, out) == inflate_status::output_limit_exceeded);
+        L2Q_CHECK(gzip_decompress(*bomb, {.max_output_size = zeros.size(), .max_ratio = 0}, out) == inflate_status::ok);
+        L2Q_CHECK(out == zeros);
+        L2Q_CHECK(gzip_decompress(*bomb, {.max_output_size = std::numeric_limits<std::size_t>::max(), .max_ratio = 0}, out) == inflate_status::ok);
+        L2Q_CHECK(out == zeros);
+    }
+
+    void invalid_data(std::mt19937& rng) {
+        const auto gzip = gzip_compress(random_text(rng, 10000));
+        L2Q_CHECK(gzip);
+        std::string out;
+        // 空输入与 gzip_compress 对空数据的结果一致，解压为空
+        L2Q_CHECK(gzip_decompress("", {}, out) == inflate_status::ok && out.empty());
+        for (const std::size_t size : {std::size_t{1}, std::size_t{10}, gzip->size() / 2, gzip->size() - 1}) {
+            L2Q_CHECK(gzip_decompress(gzip->substr(0, size), {}, out) != inflate_status::ok);
+        }
+        L2Q_CHECK(gzip_decompress("not gzip at all", {}, out) == inflate_status::invalid_data);
+    }
+} // namespace
+
+int main() {
+    std::mt19937 rng(20240601);
+    round_trip(rng);
+    default_limits();
+    invalid_data(rng);
+    return 0;
+}
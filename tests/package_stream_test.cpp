@@ -0,0 +1,101 @@
+#include "src/package_stream.h"
+
+#include <SimpleBase64.h>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "src/atomic_file.hpp"
+#include "src/compress.h"
+
+namespace {
+    using l2q_http::gzip_base64_stream;
+
+    constexpr std::string_view prefix = R"({"data":")";
+    constexpr std::string_view suffix = R"("})";
+
+    // 覆盖长度 mod 3 的各余数，以及读取块 (chunk_size) 整数倍附近的长度
+    std::vector<std::size_t> interesting_sizes() {
+        std::vector<std::size_t> sizes{0, 1, 2, 3, 4, 5};
+        for (const std::size_t blocks : {1, 2, 3}) {
+            for (std::size_t delta = 0; delta <= 6; ++delta) {
+                sizes.push_back(blocks * gzip_base64_stream::chunk_size + delta - 3);
+            }
+        }
+        return sizes;
+    }
+
+    std::string random_bytes(std::mt19937& rng, std::size_t size) {
+        std::string out(size, '\0');
+        for (auto& c : out) c = static_cast<char>(rng());
+        return out;
+    }
+
+    std::string drain(gzip_base64_stream stream) {
+        std::string out;
+        for (auto chunk = stream.next(); !chunk.empty(); chunk = stream.next()) {
+            out += chunk;
+        }
+        return out;
+    }
+
+    std::string framed(std::string_view body) {
+        return std::string{prefix} + std::string{body} + std::string{suffix};
+    }
+
+    // 两种构造方式的流式输出都与一次性 SimpleBase64::encode(gzip_compress(file)) 一致
+    void matches_one_shot(std::mt19937& rng, const std::filesystem::path& dir) {
+        const auto file = dir / "package.bin";
+        const auto object = dir / "package.bin.gz";
+
+        for (const auto size : interesting_sizes()) {
+            // 随机数据几乎不可压缩，压缩后的大小同样落在块边界附近
+            const auto data = random_bytes(rng, size);
+            l2q_http::write_file_atomic(file, data);
+
+            for (const int level : {-1, 1, 9}) {
+                const auto streamed = drain(gzip_base64_stream(file, level, std::string{prefix}, std::string{suffix}));
+                if (data.empty()) {
+                    // 字符串重载对空输入不产出 Gzip 头部，只检查能解回空内容
+                    const auto body = std::string_view{streamed}.substr(prefix.size(), streamed.size() - prefix.size() - suffix.size());
+                    const auto bytes = SimpleBase64::decode_strict(body);
+                    L2Q_CHECK(gzip_decompress(std::string_view{reinterpret_cast<const char*>(bytes.data()), bytes.size()}) == "");
+                    continue;
+                }
+                const auto gzip = gzip_compress(data, level);
+                L2Q_CHECK(gzip);
+                L2Q_CHECK(streamed == framed(SimpleBase64::encode(*gzip)));
+            }
+
+            if (const auto gzip = gzip_compress(data); gzip && !data.empty()) {
+                l2q_http::write_file_atomic(object, *gzip);
+                L2Q_CHECK(drain(gzip_base64_stream::precompressed(object, std::string{prefix}, std::string{suffix}))
+                          == framed(SimpleBase64::encode(*gzip)));
+            }
+
+            // precompressed 不检查内容，直接用任意长度的文件覆盖跨块保留的余数
+            L2Q_CHECK(drain(gzip_base64_stream::precompressed(file, std::string{prefix}, std::string{suffix}))
+                      == framed(SimpleBase64::encode(data)));
+        }
+    }
+
+    void empty_frame(const std::filesystem::path& dir) {
+        const auto file = dir / "frameless.bin";
+        l2q_http::write_file_atomic(file, "abc");
+        L2Q_CHECK(drain(gzip_base64_stream::precompressed(file, {}, {})) == "YWJj");
+    }
+} // namespace
+
+int main() {
+    std::mt19937 rng(20240601);
+    const auto dir = l2q_http::unique_temp_path(std::filesystem::temp_directory_path() / "package_stream_test");
+    std::filesystem::create_directories(dir);
+
+    matches_one_shot(rng, dir);
+    empty_frame(dir);
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
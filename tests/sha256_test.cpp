@@ -0,0 +1,111 @@
+#include "src/sha256.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "check.hpp"
+
+namespace {
+    using backend = sha256::backend;
+
+    constexpr backend all_backends[] = {backend::scalar, backend::sha_ni};
+
+    const char* backend_name(backend which) {
+        return which == backend::sha_ni ? "sha-ni" : "scalar";
+    }
+
+    std::string hex_with(std::string_view data, backend which) {
+        sha256 hasher(which);
+        hasher.update(data);
+        return sha256::to_hex(hasher.finish());
+    }
+
+    // FIPS 180-2 的示例，以及填充恰好跨过块边界的长度（55 字节是单块能容纳的最大消息）
+    void known_answers() {
+        struct vector {
+            std::string message;
+            std::string_view digest;
+        };
+        const vector vectors[] = {
+            {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+            {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+            {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+             "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+            {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+             "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"},
+            {std::string(55, 'a'), "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318"},
+            {std::string(56, 'a'), "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a"},
+            {std::string(63, 'a'), "7d3e74a05d7db15bce4ad9ec0658ea98e3f06eeecf16b4c6fff2da457ddc2f34"},
+            {std::string(64, 'a'), "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb"},
+            {std::string(65, 'a'), "635361c48bb9eab14198e76ea8ab7f1a41685d6ad62aa9146d301d4f17eb0ae0"},
+            {std::string(119, 'a'), "31eba51c313a5c08226adf18d4a359cfdfd8d2e816b13f4af952f7ea6584dcfb"},
+            {std::string(120, 'a'), "2f3d335432c70b580af0e8e1b3674a7c020d683aa5f73aaaedfdc55af904c21c"},
+            {std::string(1000000, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+        };
+
+        for (const auto& [message, digest] : vectors) {
+            L2Q_CHECK(sha256::to_hex(sha256::hash(message)) == digest);
+            for (const auto which : all_backends) {
+                if (!sha256::supported(which)) continue;
+                L2Q_CHECK(hex_with(message, which) == digest);
+            }
+        }
+    }
+
+    // 任意切分的 update 与一次性计算结果相同，finish 之后对象可以复用
+    void chunked_updates(std::mt19937& rng) {
+        for (std::size_t len = 0; len <= 300; ++len) {
+            std::string data(len, '\0');
+            for (auto& c : data) c = static_cast<char>(rng());
+            const auto expected = hex_with(data, backend::scalar);
+
+            for (const auto which : all_backends) {
+                if (!sha256::supported(which)) continue;
+                L2Q_CHECK(hex_with(data, which) == expected);
+
+                sha256 hasher(which);
+                for (int round = 0; round < 2; ++round) {
+                    std::size_t pos = 0;
+                    while (pos < len) {
+                        const std::size_t take = std::min<std::size_t>(len - pos, rng() % 80);
+                        hasher.update(std::string_view{data}.substr(pos, take));
+                        pos += take;
+                    }
+                    L2Q_CHECK(sha256::to_hex(hasher.finish()) == expected);
+                }
+            }
+        }
+    }
+
+    // 多块输入一次交给压缩函数，SHA-NI 与标量逐块一致
+    void large_inputs(std::mt19937& rng) {
+        std::string data(1 << 20, '\0');
+        for (auto& c : data) c = static_cast<char>(rng());
+
+        for (const std::size_t len : {std::size_t{4096}, std::size_t{4097}, data.size() - 1, data.size()}) {
+            const auto input = std::string_view{data}.substr(0, len);
+            const auto expected = hex_with(input, backend::scalar);
+            for (const auto which : all_backends) {
+                if (!sha256::supported(which)) continue;
+                L2Q_CHECK(hex_with(input, which) == expected);
+            }
+            L2Q_CHECK(sha256::to_hex(sha256::hash(input)) == expected);
+        }
+    }
+} // namespace
+
+int main() {
+    std::mt19937 rng(20240601);
+    known_answers();
+    chunked_updates(rng);
+    large_inputs(rng);
+
+    for (const auto which : all_backends) {
+        std::printf("%s: %s\n", backend_name(which), sha256::supported(which) ? "checked" : "unsupported, skipped");
+    }
+    return 0;
+}